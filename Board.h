@@ -5,11 +5,10 @@ enum class Square : char {
 	empty = '.', human = 'o', computer = 'x'
 };
 
-// Keeps track of where two squares are in relation to one another.
-struct Direction {
-	int dirRow;
-	int dirCol;
-};
+// Returns the other player.
+inline Square other(Square s) {
+	return (s == Square::human) ? Square::computer : Square::human;
+}
 
 // Keeps track of where on the board a Square is.
 struct Location {
@@ -17,107 +16,467 @@ struct Location {
 	int col;
 };
 
+// Everything needed to take back a move: where the piece went, who placed it, and which pieces it flipped.
+struct Undo_record {
+	uint64_t flips;
+	int square;
+	Square player;
+};
+
+// Holds how much controlling each square on the board is worth, indexed by r*8 + c.
+// Boards only keep a pointer to their table, so the table must outlive every board that uses it.
+struct Positional_table {
+	int weights[64];
+
+	// Makes a table from 8 rows of 8 values.
+	static Positional_table from_rows(const vector<vector<int>>& rows) {
+		Positional_table table;
+		for (int r = 0; r < 8; r++) {
+			for (int c = 0; c < 8; c++) {
+				table.weights[r * 8 + c] = rows[r][c];
+			}
+		}
+		return table;
+	}
+};
+
+// The positional evaluation table every board uses unless it is given another one.
+// From http://samsoft.org.uk/reversi/strategy.htm (see the README).
+constexpr Positional_table standardPositionalTable = {{
+	99,  -8,  8,  6,  6,  8,  -8, 99,
+	-8, -24, -4, -3, -3, -4, -24, -8,
+	 8,  -4,  7,  4,  4,  7,  -4,  8,
+	 6,  -3,  4,  0,  0,  4,  -3,  6,
+	 6,  -3,  4,  0,  0,  4,  -3,  6,
+	 8,  -4,  7,  4,  4,  7,  -4,  8,
+	-8, -24, -4, -3, -3, -4, -24, -8,
+	99,  -8,  8,  6,  6,  8,  -8, 99
+}};
+
+// The weights get_combined_move gives each of its heuristics, for most of the game and for the late game.
+// Each set is the weights of the positional score, the opponent's mobility, the pieces flipped, and the pieces flipped again.
+struct Combined_weights {
+	double early[4];
+	double late[4];
+	// The late game weights are used once there are this many empty squares or fewer.
+	int lateEmpties;
+};
+
+// The weights every board uses unless it is given others.
+// Determined these myself through trial and error, and the late-game weights too.
+constexpr Combined_weights standardCombinedWeights = {
+	{1, 0.3, 0.8, 0},
+	{0.1, 0.6, 0, 4},
+	10
+};
+
+// Random numbers for Zobrist hashing, one for each player on each square, plus one for the player to move.
+// A position's hash is the XOR of the numbers for every piece on the board,
+// so placing or flipping a piece only needs one or two XORs to update it.
+// Generated at compile time with splitmix64 so the hashes are the same on every run.
+struct Zobrist_keys {
+	uint64_t human[64];
+	uint64_t computer[64];
+	// human[sq] ^ computer[sq], which is what flipping a piece on sq does to the hash.
+	uint64_t flip[64];
+	uint64_t computerToMove;
+
+	constexpr Zobrist_keys()
+	: human(), computer(), flip(), computerToMove(0)
+	{
+		uint64_t state = 0x2545f4914f6cdd1dULL;
+		for (int i = 0; i < 129; i++) {
+			state += 0x9e3779b97f4a7c15ULL;
+			uint64_t z = state;
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+			z = z ^ (z >> 31);
+			if (i < 64) {
+				human[i] = z;
+			} else if (i < 128) {
+				computer[i - 64] = z;
+			} else {
+				computerToMove = z;
+			}
+		}
+		for (int i = 0; i < 64; i++) {
+			flip[i] = human[i] ^ computer[i];
+		}
+	}
+};
+
+constexpr Zobrist_keys zobrist;
+
+// Four bitboards side by side, so the move generation can work on four positions at once.
+// Operators on it apply to each lane separately, and the compiler turns them into SIMD instructions where the CPU has them.
+typedef uint64_t Bitboard4 __attribute__((vector_size(32)));
+
 // Board class
+// The position is stored as two 64-bit bitboards, one per player.
+// Square (r, c) corresponds to bit r*8 + c, so bit 0 is a1 and bit 63 is h8.
+// Boards hold no memory of their own, so copying one is just copying a few words.
 class Board {
 private:
-	// The gameboard itself.
-	vector<vector<Square>> board;
-	// Keeps track of directions that result in valid moves.
-	vector<Direction> possibleDirections;
+	// Bitboards of the squares held by each player.
+	uint64_t humanBits;
+	uint64_t computerBits;
+	// Zobrist hash of the pieces on the board, kept up to date as pieces are placed and flipped.
+	uint64_t hashKey;
 
 	// Holds the positional heuristic value of controlling each square on the board.
-	vector<vector<int>> posTable;
+	// Shared between boards rather than copied with them.
+	const Positional_table* posTable;
+	// The weights of the heuristics get_combined_move uses, also shared rather than copied.
+	const Combined_weights* combinedWeights;
+	// The positional worth of all of each player's pieces added up, kept up to date as pieces are placed and flipped.
+	int humanScore;
+	int computerScore;
+
+	// Masks that stop shifted pieces from wrapping around to the other side of the board.
+	static constexpr uint64_t notColA = 0xfefefefefefefefeULL;
+	static constexpr uint64_t notColH = 0x7f7f7f7f7f7f7f7fULL;
+
+	// Returns a reference to the bitboard holding a player's pieces.
+	uint64_t& pieces(Square s) {
+		return (s == Square::human) ? humanBits : computerBits;
+	}
+
+	// Returns a reference to the positional worth of a player's pieces.
+	int& positional_sum(Square s) {
+		return (s == Square::human) ? humanScore : computerScore;
+	}
+
+	// Returns the positional worth of square sq.
+	int weight(int sq) const {
+		return posTable->weights[sq];
+	}
 
 public:
+	// The eight directions a line of pieces can run in, as bit shifts,
+	// along with the masks that remove pieces that wrapped around the board edge.
+	static constexpr int dirShifts[8] = {1, -1, 8, -8, 9, -9, 7, -7};
+	static constexpr uint64_t dirMasks[8] = {notColA, notColH, ~0ULL, ~0ULL, notColA, notColH, notColH, notColA};
+
 	// Board constructor
 	Board()
-	: board(8)
+	: posTable(&standardPositionalTable), combinedWeights(&standardCombinedWeights), humanScore(0), computerScore(0)
 	{
-		// Sets every square on the board to be empty.
-		for(int i = 0; i < board.size(); i++) {
-			board[i] = vector<Square>(8, Square::empty);
-		}
-		// Sets the four middle squares to standard Reversi starting positions.
-		board[3][3] = Square::computer;
-		board[3][4] = Square::human;
-		board[4][4] = Square::computer;
-		board[4][3] = Square::human;
+		clear_board();
 	}
 
 	void clear_board(){
-		// Sets every square on the board to be empty.
-		for(int i = 0; i < board.size(); i++) {
-			board[i] = vector<Square>(8, Square::empty);
-		}
-		// Sets the four middle squares to standard Reversi starting positions.
-		board[3][3] = Square::computer;
-		board[3][4] = Square::human;
-		board[4][4] = Square::computer;
-		board[4][3] = Square::human;
+		// Sets every square on the board to be empty,
+		// then sets the four middle squares to standard Reversi starting positions.
+		humanBits = 0;
+		computerBits = 0;
+		hashKey = 0;
+		humanScore = 0;
+		computerScore = 0;
+		set(3, 3, Square::computer);
+		set(3, 4, Square::human);
+		set(4, 4, Square::computer);
+		set(4, 3, Square::human);
 	}
 
 	// Returns the width of the gameboard.
 	int width() const {
-		return board[0].size();
+		return 8;
 	}
 
 	// Returns the height of the gameboard.
 	int height() const {
-		return board.size();
+		return 8;
 	}
 
 	// Returns the game piece at a Square.
 	// Already assumes the Square is on the board.
 	Square get(int r, int c) const {
-		return board[r][c];
+		uint64_t bit = 1ULL << (r * 8 + c);
+		if (humanBits & bit) {
+			return Square::human;
+		} else if (computerBits & bit) {
+			return Square::computer;
+		}
+		return Square::empty;
 	}
 
 	// Places a Square on the board of a certain type (i.e. Human or Computer).
 	// Already assumes the board location is valid.
 	void set(int r, int c, const Square& s) {
-		board[r][c] = s;
+		int sq = r * 8 + c;
+		uint64_t bit = 1ULL << sq;
+		// Removes whatever was on the square from the hash and positional sums, then adds the new piece.
+		if (humanBits & bit) {
+			hashKey ^= zobrist.human[sq];
+			humanScore -= weight(sq);
+		} else if (computerBits & bit) {
+			hashKey ^= zobrist.computer[sq];
+			computerScore -= weight(sq);
+		}
+		humanBits &= ~bit;
+		computerBits &= ~bit;
+		if (s == Square::human) {
+			hashKey ^= zobrist.human[sq];
+		} else if (s == Square::computer) {
+			hashKey ^= zobrist.computer[sq];
+		}
+		if (s != Square::empty) {
+			pieces(s) |= bit;
+			positional_sum(s) += weight(sq);
+		}
+	}
+
+	// Two boards are equal if every square holds the same piece.
+	bool operator==(const Board& other) const {
+		return humanBits == other.humanBits && computerBits == other.computerBits;
+	}
+
+	// Returns the Zobrist hash of the position with the given player to move.
+	uint64_t hash(Square turn) const {
+		return (turn == Square::computer) ? hashKey ^ zobrist.computerToMove : hashKey;
+	}
+
+	// Returns the bitboard of the squares held by a player.
+	uint64_t bits(Square s) const {
+		return (s == Square::human) ? humanBits : computerBits;
+	}
+
+	// Shifts every piece on a bitboard one step in a direction,
+	// dropping the ones that would wrap around the edge of the board.
+	template<class Bits>
+	static Bits shift(Bits b, int dir) {
+		int d = dirShifts[dir];
+		return (d > 0 ? (b << d) : (b >> -d)) & dirMasks[dir];
+	}
+
+	// Kogge-Stone occluded fill.
+	// Extends the pieces in gen along a direction for as long as they pass over squares in pro.
+	// pro must already have the wrap mask for the direction applied.
+	template<class Bits, class Pro>
+	static Bits fill(Bits gen, Pro pro, int dir) {
+		int d = dirShifts[dir];
+		if (d > 0) {
+			gen |= pro & (gen << d);
+			pro &= (pro << d);
+			gen |= pro & (gen << (2 * d));
+			pro &= (pro << (2 * d));
+			gen |= pro & (gen << (4 * d));
+		} else {
+			d = -d;
+			gen |= pro & (gen >> d);
+			pro &= (pro >> d);
+			gen |= pro & (gen >> (2 * d));
+			pro &= (pro >> (2 * d));
+			gen |= pro & (gen >> (4 * d));
+		}
+		return gen;
+	}
+
+	// Returns a bitboard of every square the player p can move to against the opponent o.
+	// Works on all the squares at once by filling out from p's pieces over o's pieces in each direction.
+	// Also works on a Bitboard4, giving the moves in four positions at once.
+	template<class Bits>
+	static Bits get_moves(Bits p, Bits o) {
+		Bits empty = ~(p | o);
+		Bits moves = p & 0;
+		for (int dir = 0; dir < 8; dir++) {
+			Bits pro = o & dirMasks[dir];
+			Bits run = fill(shift(p, dir) & pro, pro, dir);
+			moves |= shift(run, dir) & empty;
+		}
+		return moves;
+	}
+
+	// Returns a bitboard of the pieces that get flipped if p moves on square sq against o.
+	// A line of o's pieces is only flipped if it is capped by one of p's pieces.
+	static uint64_t get_flips(int sq, uint64_t p, uint64_t o) {
+		uint64_t move = 1ULL << sq;
+		uint64_t flips = 0;
+		for (int dir = 0; dir < 8; dir++) {
+			uint64_t run = fill(move, o & dirMasks[dir], dir);
+			if (shift(run, dir) & p) {
+				flips |= run ^ move;
+			}
+		}
+		return flips;
+	}
+
+	// Same as above, for four moves at once, one in each lane of moves. A lane with no move gets no flips.
+	static Bitboard4 get_flips(Bitboard4 moves, uint64_t p, uint64_t o) {
+		Bitboard4 flips = moves & 0;
+		for (int dir = 0; dir < 8; dir++) {
+			Bitboard4 run = fill(moves, o & dirMasks[dir], dir);
+			// All ones in the lanes where the run is capped by one of p's pieces.
+			Bitboard4 capped = (Bitboard4)((shift(run, dir) & p) != 0);
+			flips |= (run ^ moves) & capped;
+		}
+		return flips;
+	}
+
+	// Reverses the order of the rows, so row r goes to row 7 - r.
+	static uint64_t flip_rows(uint64_t b) {
+		return __builtin_bswap64(b);
+	}
+
+	// Reverses the order of the columns, so column c goes to column 7 - c.
+	static uint64_t flip_columns(uint64_t b) {
+		b = ((b >> 1) & 0x5555555555555555ULL) | ((b & 0x5555555555555555ULL) << 1);
+		b = ((b >> 2) & 0x3333333333333333ULL) | ((b & 0x3333333333333333ULL) << 2);
+		b = ((b >> 4) & 0x0f0f0f0f0f0f0f0fULL) | ((b & 0x0f0f0f0f0f0f0f0fULL) << 4);
+		return b;
+	}
+
+	// Swaps rows and columns, so (r, c) goes to (c, r), mirroring the board in the a1-h8 diagonal.
+	static uint64_t transpose(uint64_t b) {
+		uint64_t t = 0x0f0f0f0f00000000ULL & (b ^ (b << 28));
+		b ^= t ^ (t >> 28);
+		t = 0x3333000033330000ULL & (b ^ (b << 14));
+		b ^= t ^ (t >> 14);
+		t = 0x5500550055005500ULL & (b ^ (b << 7));
+		b ^= t ^ (t >> 7);
+		return b;
+	}
+
+	// Applies one of the board's eight symmetries to a bitboard. Symmetry 0 leaves it as it is.
+	// Otherwise t & 4 transposes the board, then t & 2 flips the rows and t & 1 flips the columns.
+	static uint64_t transform(uint64_t b, int t) {
+		if (t & 4) {
+			b = transpose(b);
+		}
+		if (t & 2) {
+			b = flip_rows(b);
+		}
+		if (t & 1) {
+			b = flip_columns(b);
+		}
+		return b;
+	}
+
+	// Returns where symmetry t moves square sq to.
+	static int transform_square(int sq, int t) {
+		int r = sq / 8;
+		int c = sq % 8;
+		if (t & 4) {
+			swap(r, c);
+		}
+		if (t & 2) {
+			r = 7 - r;
+		}
+		if (t & 1) {
+			c = 7 - c;
+		}
+		return r * 8 + c;
+	}
+
+	// Returns the symmetry that undoes symmetry t.
+	// The flips undo themselves, but after a transpose, flipping the rows undoes flipping the columns and the other way round.
+	static int inverse_symmetry(int t) {
+		return (t & 4) ? (4 | (t & 1) << 1 | (t & 2) >> 1) : t;
+	}
+
+	// Turns the position where p is the player to move's pieces and o the opponent's into its canonical form:
+	// the one of its eight symmetries with the smallest p, and then the smallest o.
+	// Positions that are the same up to a rotation or reflection all have the same canonical form, so tables keyed
+	// by it share one entry between them. Returns the symmetry that was applied.
+	static int canonicalize(uint64_t& p, uint64_t& o) {
+		uint64_t ps[8];
+		uint64_t os[8];
+		ps[0] = p;
+		os[0] = o;
+		ps[4] = transpose(p);
+		os[4] = transpose(o);
+		for (int t = 0; t < 8; t += 4) {
+			ps[t | 2] = flip_rows(ps[t]);
+			os[t | 2] = flip_rows(os[t]);
+			ps[t | 1] = flip_columns(ps[t]);
+			os[t | 1] = flip_columns(os[t]);
+			ps[t | 3] = flip_columns(ps[t | 2]);
+			os[t | 3] = flip_columns(os[t | 2]);
+		}
+		int best = 0;
+		for (int t = 1; t < 8; t++) {
+			if (ps[t] < ps[best] || (ps[t] == ps[best] && os[t] < os[best])) {
+				best = t;
+			}
+		}
+		p = ps[best];
+		o = os[best];
+		return best;
+	}
+
+	// Returns a key for the position where p is the player to move's pieces and o the opponent's.
+	// Unlike hash, it doesn't depend on which colour each player has.
+	static uint64_t position_key(uint64_t p, uint64_t o) {
+		uint64_t key = 0;
+		for (; p; p &= p - 1) {
+			key ^= zobrist.human[__builtin_ctzll(p)];
+		}
+		for (; o; o &= o - 1) {
+			key ^= zobrist.computer[__builtin_ctzll(o)];
+		}
+		return key;
+	}
+
+	// Returns the position_key of the canonical form of the position with turn to move,
+	// and sets t to the symmetry that turns this board into it.
+	uint64_t canonical_key(Square turn, int& t) const {
+		uint64_t p = bits(turn);
+		uint64_t o = (humanBits | computerBits) ^ p;
+		t = canonicalize(p, o);
+		return position_key(p, o);
+	}
+
+	// Returns a bitboard of every square the player can move to.
+	uint64_t get_moves(Square s) const {
+		uint64_t p = bits(s);
+		return get_moves(p, (humanBits | computerBits) ^ p);
+	}
+
+	// Returns a bitboard of the pieces that get flipped if the player moves on square sq.
+	uint64_t get_flips(int sq, Square s) const {
+		uint64_t p = bits(s);
+		return get_flips(sq, p, (humanBits | computerBits) ^ p);
 	}
 
 	// Sets the table containing the positional heuristic value of controlling each square on the board.
-	void set_positional_table(const vector<vector<int>>& ptbl) {
-		posTable = ptbl;
+	// The board refers to the table rather than copying it, so it must outlive the board and any copies of it.
+	// Works out the positional worth of the pieces already on the board.
+	void set_positional_table(const Positional_table& ptbl) {
+		posTable = &ptbl;
+		humanScore = 0;
+		computerScore = 0;
+		for (uint64_t b = humanBits; b; b &= b - 1) {
+			humanScore += weight(__builtin_ctzll(b));
+		}
+		for (uint64_t b = computerBits; b; b &= b - 1) {
+			computerScore += weight(__builtin_ctzll(b));
+		}
+	}
+
+	// Sets the weights get_combined_move gives its heuristics.
+	// Like the positional table, the weights must outlive the board and any copies of it.
+	void set_combined_weights(const Combined_weights& weights) {
+		combinedWeights = &weights;
 	}
 
 	// Returns the positional worth of a given square.
-	int get_postional_square_score(Location loc) {
-		int r = loc.row;
-		int c = loc.col;
-		return posTable[r][c];
+	int get_postional_square_score(Location loc) const {
+		return weight(loc.row * 8 + loc.col);
 	}
 
 	// Calculates the positional strength of the player's board.
-	// Does this by adding up the positional worth of all the player's pieces 
-	// and subtracting the positional worth of all the opponent's pieces.
-	int get_positional_board_score(Square s, Square opp) {
-		int score = 0;
-		for (int r = 0; r < 8; r++) {
-			for (int c = 0; c < 8; c++) {
-				if (board[r][c] == s) {
-					score += posTable[r][c];
-				} else if (board[r][c] == opp) {
-					score -= posTable[r][c];
-				}
-			}
-		}
-		return score;
+	// This is the positional worth of all the player's pieces minus the positional worth of all the opponent's pieces,
+	// both of which are kept up to date as moves are made.
+	int get_positional_board_score(Square s, Square opp) const {
+		return (s == Square::human ? humanScore : computerScore) - (opp == Square::human ? humanScore : computerScore);
 	}
 
-	// Searches all the squares of the board and returns the number of pieces on it for a given player.
+	// Returns the number of pieces on the board for a given player.
 	int num_pieces(Square s) const {
-		int count = 0;
-		for(int i = 0; i < height(); i++) {
-			for (int j = 0; j < width(); j++) {
-				if (board[i][j] == s) {
-					count++;
-				}
-			}
+		if (s == Square::empty) {
+			return 64 - __builtin_popcountll(humanBits | computerBits);
 		}
-		return count;
+		return __builtin_popcountll(bits(s));
 	}
 
 	// Checks if a Square is on the gameboard or not.
@@ -128,15 +487,7 @@ public:
 
 	// Checks all Squares of the board to see if a move is available.
 	bool move_exists(Square s) const {
-		for (int r = 0; r < 8; r++) {
-			for (int c = 0; c < 8; c++) {
-				if (valid_move(r, c, s)) {
-					return true;
-				}
-			}
-
-		}
-		return false;
+		return get_moves(s) != 0;
 	}
 
 	// Takes in a string from the user that represents a move.
@@ -155,7 +506,7 @@ public:
 			return false;
 		}
 		// The Square must be empty for a move to be made on it.
-		if (board[r][c] != Square::empty) {
+		if (get(r, c) != Square::empty) {
 			cout << "Invalid move, piece already in space, please re-enter.\n";
 			return false;
 		}
@@ -170,142 +521,115 @@ public:
 
 	// Checks if a move is valid for any direction.
 	// If any direction would result in pieces being flipped, then it is a valid move.
-	// n and m represent the vertical and horizontal directions from the Square.
 	// Assumes Square is on the board.
 	bool valid_move(int r, int c, Square s) const {
-		if (board[r][c] != Square::empty) {
-			return false;
-		}
-		for (int n = -1; n < 2; n++) {
-			for (int m = -1; m < 2; m++) {
-				if (valid_move(r, c, n, m, s)) {
-					return true;
-				}
-			}
-		}
-		return false;
-	}
-
-	// Checks if a move for a player in a certain direction is valid.
-	// y and x represent the vertical and horizontal coordinates of the Square after moved in the m/n direction
-	bool valid_move(int r, int c, int n, int m, Square s) const {
-		int y = r+n;
-		int x = c+m;
-		// If moving in that direction takes you off the board, it is not valid.
-		if (!on_board(y, x)){
-			return false;
-		}
-		// Placing a piece adjacent to another of the same type is not a valid move
-		// (at least in the direction between the two pieces)
-		if (get(y, x) == s) {
-			return false;
-		}
-		// Keep moving in the same direction until another anchor piece is found (which makes the move valid)
-		// Or if you move off the board or hit an empty square then the move is not valid in that direction
-		while (on_board(y, x)) {
-			if (get(y, x) == s) {
-				return true;
-			} else if (get(y, x) == Square::empty) {
-				return false;
-			} else {
-				y+=n;
-				x+=m;
-			}
-		}
-		return false;
+		return (get_moves(s) >> (r * 8 + c)) & 1;
 	}
 
 	// Returns the number of empty squares on the board.
-	int num_empty_squares() {
-		int sum = 0;
-		for (int r = 0; r < 8; r++) {
-			for (int c = 0; c < 8; c++) {
-				if (board[r][c] == Square::empty) {
-					sum++;
-				}
-			}
-		}
-		return sum;
+	int num_empty_squares() const {
+		return num_pieces(Square::empty);
 	}
 
 	// Returns a vector containing all the valid moves the player can make.
+	// The moves are listed in row-major order.
 	vector<Location> get_valid_moves(Square s) const {
 		vector<Location> valid_moves;
-		for (int r = 0; r < 8; r++) {
-			for (int c = 0; c < 8; c++) {
-				if (valid_move(r, c, s)) {
-					valid_moves.push_back(Location{r,c});
-				}
-			}
+		for (uint64_t moves = get_moves(s); moves; moves &= moves - 1) {
+			int sq = __builtin_ctzll(moves);
+			valid_moves.push_back(Location{sq / 8, sq % 8});
 		}
-	return valid_moves;
+		return valid_moves;
 	}
 
 	// Returns a random valid move the player can make.
-	Location get_random_move(Square s) const {
-		vector<Location> possibilities = get_valid_moves(s);
-		int index = rand() % possibilities.size();
-		return possibilities[index];
+	Location get_random_move(Square s, Random& rng) const {
+		int sq = random_square(get_moves(s), rng);
+		return Location{sq / 8, sq % 8};
+	}
+
+	// Returns a random square from a non-empty bitboard of moves.
+	// Picks the same move get_valid_moves would have at the random index, without building a list.
+	static int random_square(uint64_t moves, Random& rng) {
+		int index = rng.below(__builtin_popcountll(moves));
+		for (int i = 0; i < index; i++) {
+			moves &= moves - 1;
+		}
+		return __builtin_ctzll(moves);
 	}
 
 	// Returns the best move the player can make using a variety of heuristics.
-	Location get_combined_move(Square s, Square opp) {
-		vector<Location> possibilities = get_valid_moves(s);
-		vector<double> good_moves;
+	// Ties are broken with rng.
+	// The moves are scored without making them: the flips and the opponent's replies after each move
+	// are worked out for four moves at a time with Bitboard4.
+	Location get_combined_move(Square s, Square opp, Random& rng) const {
+		uint64_t p = bits(s);
+		uint64_t o = bits(opp);
 
 		double positional_score;
 		double opp_moves;
 		double flipped;
 		double temp_score;
 
-		// The weights of all the heuristics.
-		// Determined these myself through trial and error.
-		double w1 = 1;
-		double w2 = 0.3;
-		double w3 = 0.8;
-		double w4 = 0;
-
-		vector<double> all_scores;
-
-		for (int i = 0; i < possibilities.size(); i++) {
-			int r = possibilities[i].row;
-			int c = possibilities[i].col;
-
-			// Creates a temporary board to make each move on.
-			Board tempBoard = *this;
-			tempBoard.make_move(possibilities[i], s);
-
-			// Returns the positional score of the player's pieces after the move has been made.
-			positional_score = tempBoard.get_positional_board_score(s, opp);
-			// Returns how many moves the opponent can make after the move has been made.
-			opp_moves = tempBoard.get_valid_moves(opp).size();
-			// Returns how many pieces will get flipped after the move has been made.
-			flipped = calc_score(r, c, s);
-
-			// The weights get adjusted during the late-game.
-			// Again, I created these weights myself through trial and error.
-			if (num_empty_squares() <= 10) {
-				w1 = 0.1;
-				w2 = 0.6;
-				w3 = 0;
-				w4 = 4;
-			}
+		// The weights of all the heuristics (see Combined_weights).
+		// The weights get adjusted during the late-game.
+		const double* w = (num_empty_squares() <= combinedWeights->lateEmpties) ? combinedWeights->late : combinedWeights->early;
+		double w1 = w[0];
+		double w2 = w[1];
+		double w3 = w[2];
+		double w4 = w[3];
+
+		// The moves, in the same order as get_valid_moves.
+		int possibilities[64];
+		int num_moves = 0;
+		for (uint64_t moves = get_moves(p, o); moves; moves &= moves - 1) {
+			possibilities[num_moves++] = __builtin_ctzll(moves);
+		}
 
-			// Weights the heuristics to generate a single score for a move.
-			temp_score = (w1 * positional_score) + (w2 * (100 / (opp_moves + 1))) + (w3 * (100 / (flipped + 1))) + (w4 * 100 * flipped);
-			all_scores.push_back(temp_score);
+		double all_scores[64];
+		int current_score = get_positional_board_score(s, opp);
+
+		for (int i = 0; i < num_moves; i += 4) {
+			// Lanes past the last move are left empty.
+			Bitboard4 placed = {0, 0, 0, 0};
+			for (int k = 0; k < 4 && i + k < num_moves; k++) {
+				placed[k] = 1ULL << possibilities[i + k];
+			}
+			Bitboard4 flips = get_flips(placed, p, o);
+			Bitboard4 replies = get_moves(o & ~flips, p | flips | placed);
+
+			for (int k = 0; k < 4 && i + k < num_moves; k++) {
+				// The positional score of the player's pieces after the move has been made.
+				// The placed piece adds to it, and each flipped piece counts for the player instead of the opponent.
+				int flipped_worth = 0;
+				for (uint64_t f = flips[k]; f; f &= f - 1) {
+					flipped_worth += weight(__builtin_ctzll(f));
+				}
+				positional_score = current_score + weight(possibilities[i + k]) + 2 * flipped_worth;
+				// How many moves the opponent can make after the move has been made.
+				opp_moves = __builtin_popcountll(replies[k]);
+				// How many pieces will get flipped after the move has been made (including the one placed).
+				flipped = __builtin_popcountll(flips[k]) + 1;
+
+				// Weights the heuristics to generate a single score for a move.
+				temp_score = (w1 * positional_score) + (w2 * (100 / (opp_moves + 1))) + (w3 * (100 / (flipped + 1))) + (w4 * 100 * flipped);
+				all_scores[i + k] = temp_score;
+			}
 		}
 
 		// Determines which moves result in the greatest score.
 		// Breaks ties randomly.
-		double max_score = *max_element(all_scores.begin(), all_scores.end());
-		for (int i = 0; i < all_scores.size(); i++) {
+		double max_score = *max_element(all_scores, all_scores + num_moves);
+		int good_moves[64];
+		int num_good = 0;
+		for (int i = 0; i < num_moves; i++) {
 			if (all_scores[i] == max_score) {
-				good_moves.push_back(i);
+				good_moves[num_good++] = i;
 			}
 		}
-		int good_index = rand() % good_moves.size();
-		return possibilities[good_moves[good_index]];
+		int good_index = rng.below(num_good);
+		int sq = possibilities[good_moves[good_index]];
+		return Location{sq / 8, sq % 8};
 	}
 
 
@@ -317,70 +641,59 @@ public:
 		make_move(move, s);
 	}
 
-	// First determine which directions can flip pieces,
-	// then for each direction that works, flip the pieces in that direction (all the ones that are flippable).
-	void make_move(Location move, Square s) {
-		int r = move.row;
-		int c = move.col;
-		for (int n = -1; n < 2; n++) {
-			for (int m = -1; m < 2; m++) {
-				if (valid_move(r, c, n, m, s)) {
-					possibleDirections.push_back(Direction{n, m});
-				}
-			}
-		}
-		set(r, c, s);
-		for (Direction &d : possibleDirections) {
-			make_move(r, c, d.dirRow, d.dirCol, s);
-		}
-		// Clears the possible directions vector for the next move.
-		possibleDirections.clear();
-	}
-
-	// Flips pieces on the gameboard in a certain direction.
-	void make_move(int r, int c, int n, int m, Square s) {
-		int x = c+m;
-		int y = r+n;
-		while (board[y][x] != s) {
-			set(y, x, s);
-			y+=n;
-			x+=m;
+	// Finds every piece the move flips in all directions at once,
+	// then places the new piece and flips them.
+	// Returns a record of the move that undo_move can use to take it back.
+	Undo_record make_move(Location move, Square s) {
+		int sq = move.row * 8 + move.col;
+		uint64_t flips = get_flips(sq, s);
+		Undo_record record{flips, sq, s};
+		uint64_t& p = pieces(s);
+		uint64_t& o = (s == Square::human) ? computerBits : humanBits;
+		p |= flips | (1ULL << sq);
+		o &= ~flips;
+		// Updates the hash and positional sums for the new piece and every flipped one.
+		hashKey ^= (s == Square::human) ? zobrist.human[sq] : zobrist.computer[sq];
+		int& pScore = positional_sum(s);
+		int& oScore = (s == Square::human) ? computerScore : humanScore;
+		pScore += weight(sq);
+		for (; flips; flips &= flips - 1) {
+			int f = __builtin_ctzll(flips);
+			hashKey ^= zobrist.flip[f];
+			pScore += weight(f);
+			oScore -= weight(f);
 		}
+		return record;
 	}
 
-	// Returns how many pieces would be flipped in a certain direction if a move was made.
-	int test_move(int r, int c, int n, int m, Square s) const {
-		int count = 0;
-		int x = c+m;
-		int y = r+n;
-		while (board[y][x] != s) {
-			count++;
-			y+=n;
-			x+=m;
+	// Takes back a move made by make_move, restoring the board exactly as it was.
+	// Moves must be undone in the reverse order they were made.
+	void undo_move(const Undo_record& record) {
+		int sq = record.square;
+		uint64_t flips = record.flips;
+		uint64_t& p = pieces(record.player);
+		uint64_t& o = (record.player == Square::human) ? computerBits : humanBits;
+		p &= ~(flips | (1ULL << sq));
+		o |= flips;
+		hashKey ^= (record.player == Square::human) ? zobrist.human[sq] : zobrist.computer[sq];
+		int& pScore = positional_sum(record.player);
+		int& oScore = (record.player == Square::human) ? computerScore : humanScore;
+		pScore -= weight(sq);
+		for (; flips; flips &= flips - 1) {
+			int f = __builtin_ctzll(flips);
+			hashKey ^= zobrist.flip[f];
+			pScore -= weight(f);
+			oScore += weight(f);
 		}
-		return count;
 	}
 
 	// Calculates how many pieces a move would score if made.
-	// Very similar to the make_move functions.
-	int calc_score(int r, int c, Square s) {
-		int count = 0;
-		if (valid_move(r, c, s)) {
-			for (int n = -1; n < 2; n++) {
-				for (int m = -1; m < 2; m++) {
-					if (valid_move(r, c, n, m, s)) {
-						possibleDirections.push_back(Direction{n, m});
-					}
-				}	
-			}
-			for (Direction &d : possibleDirections) {
-				count += test_move(r, c, d.dirRow, d.dirCol, s);
-			}
-			possibleDirections.clear();
-			count++;
+	// Counts the pieces flipped plus the piece placed, or 0 if the move is not valid.
+	int calc_score(int r, int c, Square s) const {
+		if (!valid_move(r, c, s)) {
+			return 0;
 		}
-		return count;
-
+		return __builtin_popcountll(get_flips(r * 8 + c, s)) + 1;
 	}
 
 	// Prints the gameboard.
@@ -395,7 +708,7 @@ public:
 		for(int i = 0; i < height(); i++) {
 			cout << i + 1 << " ";
 			for (int j = 0; j < width(); j++) {
-				cout << char(board[i][j]) << " ";
+				cout << char(get(i, j)) << " ";
 			}
 			cout << endl;
 		}
@@ -426,4 +739,6 @@ public:
 		}
 	}
 
-}; // Class Board
\ No newline at end of file
+}; // Class Board
+
+static_assert(is_trivially_copyable<Board>::value, "Boards are copied constantly during search and must stay cheap to copy");
\ No newline at end of file
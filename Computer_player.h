@@ -1,15 +1,184 @@
 // Computer_player.h
 
+// The ways a Monte Carlo search can be split across threads.
+// root: every thread grows its own tree and the visit counts at the root are added together at the end.
+// tree: every thread works on the one shared tree, using virtual losses to spread out.
+enum class Parallel_mode {
+	root, tree
+};
+
 // Computer Player class
 class Computer_player : public Player {
 private:
 	// Square type to identify Computer's piece.
 	Square s;
 	Square opp;
+
+	// Holds the Monte Carlo search tree, which is kept from one move to the next.
+	// Made by the first MCTS search, so players that never search don't hold its memory.
+	unique_ptr<Search_tree> tree;
+	static constexpr int treeCapacity = 1 << 18;
+	// The position at the root of the tree.
+	Board treeBoard;
+	// The root's child that was played after the last search, or -1 if the tree cannot be reused.
+	int chosenChild;
+	// The exploration constant used by UCB1.
+	double exploration;
+
+	// The player's own random numbers, used for its moves and to seed threadRngs before each search.
+	Random rng;
+	// One generator for each search thread, so threads never share random numbers.
+	vector<Random> threadRngs;
+
+	// How many threads search at once and how they share the work.
+	int numThreads;
+	Parallel_mode parallelMode;
+	// The trees grown by the extra threads in root parallel mode. They are not kept between moves.
+	// Made by the first root parallel search that needs them, like tree.
+	vector<unique_ptr<Search_tree>> helperTrees;
+	static constexpr int helperTreeCapacity = 1 << 16;
+
+	// Remembers positions seen by alpha-beta, and by MCTS if useTable is set.
+	// Made by the first search that uses it.
+	unique_ptr<Transposition_table> table;
+	static constexpr int tableBits = 18;
+	bool useTable;
+	// XORed into the keys alpha-beta uses, so its entries never mix with the ones MCTS stores.
+	static constexpr uint64_t alphaBetaSalt = 0x5bd1e9955bd1e995ULL;
+
+	// Solves the last endgameEmpties empty squares exactly.
+	Endgame_solver solver;
+	int endgameEmpties;
+
+	// The opening book, if the player has one. Searches play its move instead whenever the position is in it.
+	unique_ptr<Opening_book> book;
+
+	// Scores the positions at the leaves of alpha-beta searches, if the player has one. Otherwise the positional table does.
+	// Only read, so one can be shared by every player.
+	shared_ptr<const Pattern_eval> patternEval;
+	// The pattern codes of the position being searched by alpha-beta, when patternEval is used.
+	Pattern_codes codes;
+
+	// Limits how long each search takes, and keeps the game clock if there is one.
+	Time_control timeControl;
+	// MCTS only reads the clock once every this many playouts, as reading it costs about as much as a few playout moves.
+	static constexpr int clockCheckInterval = 16;
+
+	// Number of positions visited by the current alpha-beta search.
+	long long nodesSearched;
+	// The most positions the current alpha-beta search can visit, or 0 for no limit.
+	long long maxNodes;
+	// Number of playouts made by the last MCTS search, not counting ones kept from earlier searches.
+	long long playoutsSearched;
+	// Score given to a finished game, plus or minus the piece difference. Bigger than any positional score.
+	static constexpr int winScore = 10000;
+
+	// Converts a square index from the search tree back into a Location.
+	static Location to_location(int sq) {
+		return Location{sq / 8, sq % 8};
+	}
+
+	// Makes the transposition table if no search has needed it yet.
+	void make_table() {
+		if (table == nullptr) {
+			table = make_unique<Transposition_table>(tableBits);
+		}
+	}
+
+	// Returns the first valid move in row-major order, for when a search ends without having tried any.
+	Location first_move(const Board& b) const {
+		return to_location(__builtin_ctzll(b.get_moves(s)));
+	}
+
+	// Looks for the position b below the move played after the last search, i.e. after the opponent's reply.
+	// If it is found, that node becomes the new root so its playouts are kept, and the rest of the tree is freed.
+	bool reuse_tree(const Board& b) {
+		int played = chosenChild;
+		chosenChild = -1;
+		if (played == -1) {
+			return false;
+		}
+		Board afterMove = treeBoard;
+		if ((*tree)[played].move != -1) {
+			afterMove.make_move(to_location((*tree)[played].move), s);
+		}
+		for (int c = tree->first_child(played); c != -1; c = (*tree)[c].nextSibling) {
+			Board afterReply = afterMove;
+			if ((*tree)[c].move != -1) {
+				afterReply.make_move(to_location((*tree)[c].move), opp);
+			}
+			if (afterReply == b) {
+				tree->promote(c);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Runs MCTS iterations on a tree rooted at position b until the root has target visits or the deadline passes.
+	// Each iteration walks down the tree picking children by UCB1, adds one new node,
+	// plays out the rest of the game from there, and adds the result to every node on the path.
+	// Several threads can run this on the same tree at once, each with its own random number generator.
+	template<class Policy>
+	void search(Search_tree& t, const Board& b, int target, chrono::steady_clock::time_point deadline,
+			Random& random) {
+		int iterations = 0;
+		while (t[t.root()].visits.load(memory_order_relaxed) < target) {
+			// Stop searching if more than the allotted time has passed.
+			// The clock is first read after some playouts, so there is always at least one to choose a move from.
+			if (++iterations % clockCheckInterval == 0 && chrono::steady_clock::now() > deadline) {
+				break;
+			}
+
+			Board temp = b; // Creates a temporary copy of the board to walk down the tree on.
+			int node = t.root();
+			t.add_visit(node);
+			Square turn = s;
+
+			// Selection: follow the best children until reaching a node that still has moves to expand.
+			while (!t.can_expand(node) && t.first_child(node) != -1) {
+				node = t.select_child(node, exploration, useTable ? table.get() : nullptr);
+				t.add_visit(node);
+				if (t[node].move != -1) {
+					temp.make_move(to_location(t[node].move), turn);
+				}
+				turn = (turn == s) ? opp : s;
+			}
+
+			// Expansion: add one child for a move that has not been tried yet.
+			if (t.can_expand(node)) {
+				int child = t.expand(node, temp, turn, (turn == s) ? opp : s);
+				if (child != -1) {
+					node = child;
+					t.add_visit(node);
+					turn = (turn == s) ? opp : s;
+				}
+			}
+
+			// Simulation and backpropagation.
+			t.backpropagate(node, play_out<Policy>(temp, turn, random), s, useTable ? table.get() : nullptr);
+		}
+	}
+
+	// Takes the time from when it is made until it goes out of scope off the player's game clock.
+	struct Move_timer {
+		Time_control& clock;
+		chrono::steady_clock::time_point start;
+
+		Move_timer(Time_control& c)
+		: clock(c), start(chrono::steady_clock::now())
+		{	}
+
+		~Move_timer() {
+			clock.end_move(chrono::duration<double>(chrono::steady_clock::now() - start).count());
+		}
+	};
 public:
 	// Constructor
 	Computer_player() 
-	: s(Square::computer), opp(Square::human)
+	: s(Square::computer), opp(Square::human), chosenChild(-1), exploration(sqrt(2)),
+	  threadRngs(1), numThreads(1), parallelMode(Parallel_mode::tree),
+	  useTable(false), endgameEmpties(20), nodesSearched(0), maxNodes(0), playoutsSearched(0)
 	{	}
 
 	// Destructor
@@ -19,6 +188,101 @@ public:
 	void invert_pieces() {
 		s = Square::human;
 		opp = Square::computer;
+		chosenChild = -1;
+	}
+
+	// Gets the player ready for a new game: starts its random numbers over from a seed, forgets everything learned
+	// in earlier searches, and resets its game clock, so that the game comes out the same every time.
+	// Only searches that stop on their playout, node, or depth limit rather than the clock, and use one thread, are exactly repeatable.
+	void new_game(uint64_t seed) {
+		rng.seed(seed);
+		chosenChild = -1;
+		if (table != nullptr) {
+			table->clear();
+		}
+		timeControl.new_game();
+	}
+
+	// Sets how many threads MCTS uses and how they share the search.
+	void set_threads(int threads, Parallel_mode mode) {
+		numThreads = max(threads, 1);
+		parallelMode = mode;
+		threadRngs.resize(numThreads);
+	}
+
+	// Sets whether MCTS shares playout statistics between positions reached by different move orders.
+	void set_transpositions(bool on) {
+		useTable = on;
+	}
+
+	// Sets how many empty squares there must be at most before the endgame solver is used instead of searching.
+	// Each extra empty square makes the solver several times slower; 20, the default, takes up to a few tenths of a second
+	// in an optimized build. Searches only give the solver half their time, so it gives up on positions it can't finish. 0 turns it off.
+	void set_endgame_empties(int empties) {
+		endgameEmpties = empties;
+	}
+
+	// Sets how long searches can take to choose a move.
+	// Takes effect at the start of the next game if the player has a game clock.
+	void set_time_control(const Time_control& control) {
+		timeControl = control;
+	}
+
+	// Returns the player's time control, e.g. to see the time left on its game clock.
+	const Time_control& time_control() const {
+		return timeControl;
+	}
+
+	// Opens an opening book for the searches to use. The file is mapped into memory rather than read.
+	void load_opening_book(const string& filename) {
+		book = make_unique<Opening_book>(filename);
+	}
+
+	// Sets the pattern evaluation alpha-beta scores positions with, or nullptr to use the positional table.
+	void set_pattern_eval(shared_ptr<const Pattern_eval> eval) {
+		patternEval = eval;
+	}
+
+	// Returns true and sets move if the opening book has a move for the position.
+	bool book_move(const Board& b, Location& move) const {
+		return book != nullptr && book->find_move(b, s, move);
+	}
+
+	// Uses the endgame solver if there are few enough empty squares left.
+	// Returns true and sets move if the solver finished before the deadline and found a move that wins or draws.
+	// If every move loses, the caller's own search picks the move instead, as it may find one the opponent gets wrong.
+	bool solve_endgame(const Board& b, chrono::steady_clock::time_point deadline, Location& move) {
+		if (b.num_empty_squares() > endgameEmpties) {
+			return false;
+		}
+		int result;
+		return solver.best_move(b, s, deadline, move, result) && result >= 0;
+	}
+
+	// Returns the greedy heuristic move, or the solver's move once the endgame can be solved in the time for a move.
+	Location greedy_move(Board& b) {
+		Move_timer timer(timeControl);
+		Search_budget budget = timeControl.start_move(b.num_empty_squares());
+		Location move;
+		if (solve_endgame(b, budget.deadline, move)) {
+			return move;
+		}
+		return b.get_combined_move(s, opp, rng);
+	}
+
+	// Returns a random valid move.
+	Location random_move(const Board& b) {
+		return b.get_random_move(s, rng);
+	}
+
+	// Returns the number of playouts made by the last MCTS search.
+	long long playouts_searched() const {
+		return playoutsSearched;
+	}
+
+	// Returns the number of positions searched by the last alpha-beta search.
+	long long nodes_searched() const {
+		return nodesSearched;
 	}
 
 	// Let's the player know the computer is going.
@@ -36,97 +300,360 @@ public:
 
 	// Determines if the CPU won, tied, or lost.
 	// Returns 1 if the CPU won, 0.5 if they tied, and 0 if they lost.
-	double get_playout_score(Board b) {
-		if(b.num_pieces(s) > b.num_pieces(opp)){
+	double get_playout_score(const Board& b) const {
+		return get_playout_score(b.num_pieces(s), b.num_pieces(opp));
+	}
+
+	// Same as above, but from the number of pieces the CPU and its opponent have.
+	static double get_playout_score(int mine, int theirs) {
+		if (mine > theirs) {
 			return 1;
-		} else if (b.num_pieces(s) < b.num_pieces(opp)) {
+		} else if (mine < theirs) {
 			return 0;
 		} else {
 			return 0.5;
 		}
 	}
 
-	// Plays out the remainder of the game using either random moves or heuristic moves and returns the playout score.
-	double play_out(Board b, string heuristic) {
-		int lost_turns = 0;
-		Location human_move;
-		Location computer_move;
-		while (true) {
-			if (b.move_exists(opp)) {
-				if (heuristic == "pure") {
-					human_move = b.get_random_move(opp);
-				} else if (heuristic == "combined") {
-					human_move = b.get_random_move(opp);
+	// Plays out the remainder of the game with moves chosen by the playout policy and returns the playout score.
+	// turn is the player who moves first in the playout.
+	// Policies that only need the bitboards flip pieces in place on a copy of them and never allocate memory.
+	// Policies that need the whole board have their moves made on b, and taken back afterwards so b is left as it was.
+	template<class Policy>
+	double play_out(Board& b, Square turn, Random& random) const {
+		if constexpr (Policy::usesBoard) {
+			// A game can't have more moves than the 60 empty squares it starts with.
+			Undo_record history[60];
+			int num_moves = 0;
+			int lost_turns = 0;
+			while (lost_turns < 2) {
+				uint64_t moves = b.get_moves(turn);
+				if (moves != 0) {
+					int sq = Policy::choose(b, moves, turn, s, opp, random);
+					history[num_moves++] = b.make_move(to_location(sq), turn);
+					lost_turns = 0;
+				} else {
+					lost_turns++;
 				}
-				b.make_move(human_move, opp);
-				lost_turns = 0;
-			} else {
-				lost_turns++;
-			}
-			if (lost_turns == 2) {
-				return get_playout_score(b);
-			}
-			
-			if (b.move_exists(s)) {
-				if (heuristic == "pure") {
-					computer_move = b.get_random_move(s);
-				} else if (heuristic == "combined") {
-					computer_move = b.get_combined_move(s, opp);
+				turn = (turn == s) ? opp : s;
+			}
+			double score = get_playout_score(b);
+			while (num_moves > 0) {
+				b.undo_move(history[--num_moves]);
+			}
+			return score;
+		} else {
+			uint64_t mine = b.bits(s);
+			uint64_t theirs = b.bits(opp);
+			bool myTurn = (turn == s);
+			int lost_turns = 0;
+			while (lost_turns < 2) {
+				uint64_t& p = myTurn ? mine : theirs;
+				uint64_t& o = myTurn ? theirs : mine;
+				uint64_t moves = Board::get_moves(p, o);
+				if (moves != 0) {
+					int sq = Policy::choose(p, o, moves, myTurn, random);
+					uint64_t flips = Board::get_flips(sq, p, o);
+					p |= flips | (1ULL << sq);
+					o &= ~flips;
+					lost_turns = 0;
+				} else {
+					lost_turns++;
 				}
-				b.make_move(computer_move, s);
-				lost_turns = 0;
+				myTurn = !myTurn;
 			}
-			if (lost_turns == 2) {
-				return get_playout_score(b);
+			return get_playout_score(__builtin_popcountll(mine), __builtin_popcountll(theirs));
+		}
+	}
+
+	// Performs Monte Carlo tree search using UCT.
+	// The playouts choose their moves with the Policy (see Playout_policy.h).
+	// In the opening the book move is played if there is one, and once the endgame can be solved exactly, the solver's move is.
+	// The search stops when the time control's budget runs out. By default that is once each thread's root has
+	// 250 playouts per valid move or after 5 seconds, whichever comes first.
+	// Then the move that was visited the most is returned.
+	// If the position follows on from the last search, the matching part of the old tree is reused.
+	template<class Policy>
+	Location MCTS(Board b) {
+		Move_timer timer(timeControl);
+		Search_budget budget = timeControl.start_move(b.num_empty_squares());
+		if (tree == nullptr) {
+			tree = make_unique<Search_tree>(treeCapacity);
+		}
+		if (useTable) {
+			make_table();
+			table->new_search();
+		}
+
+		// Plays the book move in the opening, and near the end of the game tries to solve it exactly in the first half of the time.
+		Location solved;
+		playoutsSearched = 0;
+		if (book_move(b, solved) || solve_endgame(b, budget.solverDeadline, solved)) {
+			chosenChild = -1;
+			return solved;
+		}
+
+		// The root is reached by a move from the opponent, so it is the computer's turn.
+		if (!reuse_tree(b)) {
+			tree->reset(b, s, opp);
+		}
+		treeBoard = b;
+		int reusedPlayouts = (*tree)[tree->root()].visits;
+
+		// How many visits the root of each tree has to reach. In tree parallel mode all the threads share one tree.
+		bool sharedTree = (numThreads > 1 && parallelMode == Parallel_mode::tree);
+		long long target = INT_MAX;
+		// Playouts kept from the last search count towards the target, except when the number of playouts is fixed.
+		int kept = 0;
+		if (budget.maxCount != 0) {
+			// A fixed number of new playouts, split between the threads' trees in root parallel mode.
+			target = budget.maxCount;
+			if (numThreads > 1 && !sharedTree) {
+				target = max(target / numThreads, 1LL);
 			}
+			kept = reusedPlayouts;
+		} else if (budget.playoutsPerMove != 0) {
+			// A number of playouts per valid move for each thread.
+			target = (long long)budget.playoutsPerMove * __builtin_popcountll(b.get_moves(s)) * (sharedTree ? numThreads : 1);
+		}
+		int treeTarget = min(target + kept, (long long)INT_MAX);
+		int helperTarget = min(target, (long long)INT_MAX);
+
+		// Gives every thread fresh random numbers drawn from the player's own, so a seeded player searches the same way each time.
+		for (Random& r : threadRngs) {
+			r.seed(rng.next());
 		}
+
+		if (numThreads == 1) {
+			search<Policy>(*tree, b, treeTarget, budget.deadline, threadRngs[0]);
+		} else if (sharedTree) {
+			// Every thread adds to the shared tree until it reaches the target.
+			vector<thread> workers;
+			for (int i = 1; i < numThreads; i++) {
+				workers.emplace_back(&Computer_player::search<Policy>, this, ref(*tree), cref(b),
+					treeTarget, budget.deadline, ref(threadRngs[i]));
+			}
+			search<Policy>(*tree, b, treeTarget, budget.deadline, threadRngs[0]);
+			for (thread& w : workers) {
+				w.join();
+			}
+		} else {
+			// Every thread grows its own tree, then the visits of each root move are added up.
+			vector<thread> workers;
+			while (helperTrees.size() < numThreads - 1) {
+				helperTrees.push_back(make_unique<Search_tree>(helperTreeCapacity));
+			}
+			for (int i = 0; i < numThreads - 1; i++) {
+				helperTrees[i]->reset(b, s, opp);
+				workers.emplace_back(&Computer_player::search<Policy>, this, ref(*helperTrees[i]), cref(b),
+					helperTarget, budget.deadline, ref(threadRngs[i + 1]));
+			}
+			search<Policy>(*tree, b, treeTarget, budget.deadline, threadRngs[0]);
+			for (thread& w : workers) {
+				w.join();
+			}
+
+			long long visits[64] = {};
+			for (int i = -1; i < numThreads - 1; i++) {
+				Search_tree& t = (i == -1) ? *tree : *helperTrees[i];
+				for (int c = t.first_child(t.root()); c != -1; c = t[c].nextSibling) {
+					visits[t[c].move] += t[c].visits;
+				}
+				playoutsSearched += t[t.root()].visits;
+			}
+			playoutsSearched -= reusedPlayouts;
+			int best = max_element(visits, visits + 64) - visits;
+			if (visits[best] == 0) {
+				return first_move(b);
+			}
+			// Remembers the move so the tree can be reused next turn, if the first thread's tree searched it.
+			chosenChild = tree->find_child(tree->root(), best);
+			return to_location(best);
+		}
+
+		playoutsSearched = (*tree)[tree->root()].visits - reusedPlayouts;
+		// Returns the move that was searched the most and remembers it so the tree can be reused next turn.
+		chosenChild = tree->most_visited_child(tree->root());
+		if (chosenChild == -1) {
+			return first_move(b);
+		}
+		return to_location((*tree)[chosenChild].move);
 	}
 
-	// Performs Monte Carlo tree search.
-	// Either a pure or heuristic version.
-	// Uses a number of playouts to make better moves.
-	// Caps the time allowed to make a move at 5 seconds.
-	// It does this by dividing 5 by the number of valid moves to perform playouts on.
-	// It spends at most that amount of time on each move, or it stops sooner if 250 playouts have been done.
-	// If less than 250 playouts can be performed for a given move, the score is adjusted to as if 250 playouts were done.
-	// This prevents the program from simply picking the move that had the most random playouts done on it.
-	Location MCTS(Board b, string heursitic) {
-		int num_playouts = 250;
-		double max_seconds = 5;
-		double max_milliseconds = max_seconds * 1000;
-		vector<Location> val_moves = b.get_valid_moves(s);
-		vector<double> scores (val_moves.size());
-		auto time_per = max_milliseconds / val_moves.size(); // This determines how long to spend on each move.
-
-		for (int i = 0; i < val_moves.size(); i++) { // For every valid move...
-			auto start = chrono::steady_clock::now();
-			for (int j = 0; j < num_playouts; j++) { // Perform a set amount of playouts...
-				auto end = chrono::steady_clock::now();
-				auto elapsed = chrono::duration_cast<chrono::milliseconds>(end - start).count();
-				// Stop performing playouts if more than the allotted time has passed.
-				if (elapsed > time_per) {
-					// This adjusts the score of making the move to as if all 250 playouts were done.
-					scores[i] = scores[i] * (250.0 / j);
-					break;
+	// Returns the score of a finished game for the player turn.
+	// Wins and losses are worth more than any position, and bigger margins are worth more.
+	static int final_score(const Board& b, Square turn, Square other) {
+		int diff = b.num_pieces(turn) - b.num_pieces(other);
+		if (diff > 0) {
+			return winScore + diff;
+		} else if (diff < 0) {
+			return -winScore + diff;
+		}
+		return 0;
+	}
+
+	// Searches position b to the given depth with negamax alpha-beta and returns its score for the player to move.
+	// Moves are made and taken back on b itself, so it is left as it was.
+	// Positions already searched deeply enough are looked up in the transposition table instead of searched again.
+	// Sets timedOut and gives up if the deadline passes or more than maxNodes positions have been searched.
+	int negamax(Board& b, Square turn, Square other, int depth, int alpha, int beta,
+			chrono::steady_clock::time_point deadline, bool& timedOut) {
+		// Only checks the clock every 1024 positions, as reading it is slow.
+		if ((++nodesSearched & 1023) == 0 && chrono::steady_clock::now() > deadline) {
+			timedOut = true;
+		}
+		if (maxNodes != 0 && nodesSearched > maxNodes) {
+			timedOut = true;
+		}
+		if (timedOut) {
+			return 0;
+		}
+		if (depth == 0) {
+			if (patternEval != nullptr) {
+				return patternEval->evaluate(codes, turn, b.num_empty_squares());
+			}
+			return b.get_positional_board_score(turn, other);
+		}
+
+		uint64_t key = b.hash(turn) ^ alphaBetaSalt;
+		uint64_t payload;
+		int storedDepth;
+		int tableMove = -1;
+		if (table->probe(key, payload, storedDepth)) {
+			Search_entry e = Search_entry::unpack(payload);
+			tableMove = e.move;
+			if (storedDepth >= depth) {
+				if (e.bound == Bound::exact
+					|| (e.bound == Bound::lower && e.score >= beta)
+					|| (e.bound == Bound::upper && e.score <= alpha)) {
+					return e.score;
 				}
-				Board temp = b; // Creates a temporary copy of the board to perform the random playouts on.
-				temp.make_move(val_moves[i], s);
-				scores[i] += play_out(temp, heursitic);
 			}
 		}
-		// This vector stores the indices of all the moves that result in the highest score.
-		vector<double> max_moves;
-		double max_score = *max_element(scores.begin(), scores.end());
-		for (int i = 0; i < scores.size(); i++) {
-			if (scores[i] == max_score) {
-				max_moves.push_back(i);
+
+		uint64_t moves = b.get_moves(turn);
+		if (moves == 0) {
+			// If neither player can move the game is over, otherwise the player passes.
+			if (!b.move_exists(other)) {
+				return final_score(b, turn, other);
+			}
+			return -negamax(b, other, turn, depth, -beta, -alpha, deadline, timedOut);
+		}
+
+		// Tries the best move from the table first, then the moves on the most valuable squares,
+		// as they are most likely to cause a cutoff.
+		int squares[64];
+		int weights[64];
+		int n = 0;
+		for (; moves; moves &= moves - 1) {
+			int sq = __builtin_ctzll(moves);
+			int weight = (sq == tableMove) ? winScore : b.get_postional_square_score(to_location(sq));
+			int i = n++;
+			while (i > 0 && weights[i - 1] < weight) {
+				squares[i] = squares[i - 1];
+				weights[i] = weights[i - 1];
+				i--;
+			}
+			squares[i] = sq;
+			weights[i] = weight;
+		}
+
+		int originalAlpha = alpha;
+		int bestMove = squares[0];
+		for (int i = 0; i < n; i++) {
+			Undo_record record = b.make_move(to_location(squares[i]), turn);
+			if (patternEval != nullptr) {
+				codes.make_move(record);
+			}
+			int score = -negamax(b, other, turn, depth - 1, -beta, -alpha, deadline, timedOut);
+			b.undo_move(record);
+			if (patternEval != nullptr) {
+				codes.undo_move(record);
 			}
+			if (score > alpha) {
+				alpha = score;
+				bestMove = squares[i];
+				if (alpha >= beta) {
+					break;
+				}
+			}
+		}
+		if (timedOut) {
+			return 0;
+		}
+
+		Bound bound = Bound::exact;
+		if (alpha >= beta) {
+			bound = Bound::lower;
+		} else if (alpha <= originalAlpha) {
+			bound = Bound::upper;
+		}
+		table->store(key, Search_entry{alpha, bound, bestMove}.pack(), depth);
+		return alpha;
+	}
+
+	// Performs a negamax alpha-beta search using the pattern evaluation at the leaves if the player has pattern weights,
+	// or the positional heuristic if not.
+	// Uses iterative deepening: searches 1 move ahead, then 2, and so on, stopping when the time control's budget
+	// runs out or the search reaches the end of the game. By default that is after 8 moves deep or 5 seconds.
+	// In the opening the book move is played if there is one, and once the endgame can be solved exactly, the solver's move is.
+	// The best move from each depth is searched first at the next one.
+	// If a depth runs out of time or nodes its result is thrown away and the best move from the last complete depth is used.
+	Location alpha_beta(Board b) {
+		Move_timer timer(timeControl);
+		Search_budget budget = timeControl.start_move(b.num_empty_squares());
+		int max_depth = budget.maxDepth;
+		auto deadline = budget.deadline;
+		const int infinity = 1000000;
+
+		nodesSearched = 0;
+
+		// Plays the book move in the opening, and near the end of the game tries to solve it exactly in the first half of the time.
+		Location solved;
+		if (book_move(b, solved) || solve_endgame(b, budget.solverDeadline, solved)) {
+			return solved;
+		}
+
+		vector<Location> val_moves = b.get_valid_moves(s);
+		bool timedOut = false;
+		maxNodes = budget.maxCount;
+		make_table();
+		table->new_search();
+		if (patternEval != nullptr) {
+			codes.set(b);
 		}
-		// If more than one move results in the same max score, this randomly choose one.
-		int max_index = rand() % max_moves.size();
 
-		// Returns the move that corresponds to the highest playout score.
-		return val_moves[max_moves[max_index]];
+		for (int depth = 1; depth <= max_depth; depth++) {
+			int alpha = -infinity;
+			int best = 0;
+			for (int i = 0; i < val_moves.size(); i++) {
+				Undo_record record = b.make_move(val_moves[i], s);
+				if (patternEval != nullptr) {
+					codes.make_move(record);
+				}
+				int score = -negamax(b, opp, s, depth - 1, -infinity, -alpha, deadline, timedOut);
+				b.undo_move(record);
+				if (patternEval != nullptr) {
+					codes.undo_move(record);
+				}
+				if (timedOut) {
+					break;
+				}
+				if (score > alpha) {
+					alpha = score;
+					best = i;
+				}
+			}
+			if (timedOut) {
+				break;
+			}
+			// Moves the best move to the front so it is searched first next time.
+			rotate(val_moves.begin(), val_moves.begin() + best, val_moves.begin() + best + 1);
+			if (depth >= b.num_empty_squares()) {
+				break;
+			}
+		}
+		return val_moves[0];
 	}
 
 	// Informs the player that the computer is unable to make a move and it will be their turn again.
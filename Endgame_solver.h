@@ -0,0 +1,236 @@
+// Endgame_solver.h
+
+// Endgame solver class
+// Plays out every possible continuation of a position near the end of the game to find its exact result.
+// Works directly on the two bitboards: p is always the player to move and o the opponent.
+// Scores are the player to move's pieces minus the opponent's pieces at the end of the game.
+// Moves are ordered so the search cuts off as early as possible:
+//  - with more than 6 empty squares, moves that leave the opponent the fewest replies go first (with corners first on ties),
+//  - with fewer, moves into regions of the board with an odd number of empty squares go first (parity),
+//  - the last 4 empty squares are handled by a separate routine for each count that skips move generation entirely.
+class Endgame_solver {
+private:
+	// Number of positions searched so far.
+	long long nodes;
+	chrono::steady_clock::time_point deadline;
+	bool timedOut;
+
+	static constexpr uint64_t corners = 0x8100000000000081ULL;
+
+	// Returns which quarter of the board a square is in.
+	static int quadrant(int sq) {
+		return ((sq >> 5) & 1) * 2 + ((sq >> 2) & 1);
+	}
+
+	// Returns the final score if neither player can move.
+	static int final_score(uint64_t p, uint64_t o) {
+		return __builtin_popcountll(p) - __builtin_popcountll(o);
+	}
+
+	// Solves a position with exactly one empty square.
+	static int solve_1(uint64_t p, uint64_t o, int sq) {
+		int mine = __builtin_popcountll(p);
+		int theirs = __builtin_popcountll(o);
+		int flipped = __builtin_popcountll(Board::get_flips(sq, p, o));
+		if (flipped > 0) {
+			return (mine + flipped + 1) - (theirs - flipped);
+		}
+		// The player to move has to pass, so the opponent gets the last square if they can use it.
+		flipped = __builtin_popcountll(Board::get_flips(sq, o, p));
+		if (flipped > 0) {
+			return (mine - flipped) - (theirs + flipped + 1);
+		}
+		return mine - theirs;
+	}
+
+	// Solves a position with exactly N empty squares, listed in squares.
+	// Tries each empty square in turn instead of generating moves, as there are so few of them.
+	template<int N>
+	int solve_last(uint64_t p, uint64_t o, int alpha, int beta, const int* squares, bool passed) {
+		nodes++;
+		int best = -65;
+		for (int i = 0; i < N; i++) {
+			int sq = squares[i];
+			uint64_t flips = Board::get_flips(sq, p, o);
+			if (flips == 0) {
+				continue;
+			}
+			// The squares that are still empty after this move.
+			int rest[N > 1 ? N - 1 : 1];
+			for (int j = 0, k = 0; j < N; j++) {
+				if (j != i) {
+					rest[k++] = squares[j];
+				}
+			}
+			int score;
+			if (N == 2) {
+				score = -solve_1(o & ~flips, p | flips | (1ULL << sq), rest[0]);
+			} else {
+				score = -solve_last<(N > 2 ? N - 1 : 2)>(o & ~flips, p | flips | (1ULL << sq), -beta, -max(alpha, best), rest, false);
+			}
+			if (score > best) {
+				best = score;
+				if (best >= beta) {
+					return best;
+				}
+			}
+		}
+		if (best == -65) {
+			// No moves, so either pass or the game is over.
+			if (passed) {
+				return final_score(p, o);
+			}
+			return -solve_last<N>(o, p, -beta, -alpha, squares, true);
+		}
+		return best;
+	}
+
+	// Lists the empty squares, putting the ones in quarters of the board with an odd number of empty squares first.
+	static int parity_order(uint64_t empty, int* squares) {
+		int counts[4] = {0, 0, 0, 0};
+		for (uint64_t e = empty; e; e &= e - 1) {
+			counts[quadrant(__builtin_ctzll(e))]++;
+		}
+		int n = 0;
+		for (int odd = 1; odd >= 0; odd--) {
+			for (uint64_t e = empty; e; e &= e - 1) {
+				int sq = __builtin_ctzll(e);
+				if ((counts[quadrant(sq)] & 1) == odd) {
+					squares[n++] = sq;
+				}
+			}
+		}
+		return n;
+	}
+
+	// Solves a position with any number of empty squares using alpha-beta,
+	// handing off to the specialized routines once there are 4 or fewer left.
+	int solve(uint64_t p, uint64_t o, int alpha, int beta, bool passed) {
+		// Only checks the clock every 4096 positions, as reading it is slow.
+		if ((++nodes & 4095) == 0 && chrono::steady_clock::now() > deadline) {
+			timedOut = true;
+		}
+		if (timedOut) {
+			return 0;
+		}
+		uint64_t empty = ~(p | o);
+		int numEmpty = __builtin_popcountll(empty);
+		if (numEmpty <= 4) {
+			int squares[4];
+			parity_order(empty, squares);
+			switch (numEmpty) {
+				case 0: return final_score(p, o);
+				case 1: return solve_1(p, o, squares[0]);
+				case 2: return solve_last<2>(p, o, alpha, beta, squares, passed);
+				case 3: return solve_last<3>(p, o, alpha, beta, squares, passed);
+				default: return solve_last<4>(p, o, alpha, beta, squares, passed);
+			}
+		}
+
+		uint64_t moves = Board::get_moves(p, o);
+		if (moves == 0) {
+			if (passed) {
+				return final_score(p, o);
+			}
+			return -solve(o, p, -beta, -alpha, true);
+		}
+
+		int squares[64];
+		int n = order_moves(p, o, moves, squares);
+		for (int i = 0; i < n; i++) {
+			uint64_t flips = Board::get_flips(squares[i], p, o);
+			int score = -solve(o & ~flips, p | flips | (1ULL << squares[i]), -beta, -alpha, false);
+			if (score > alpha) {
+				alpha = score;
+				if (alpha >= beta) {
+					break;
+				}
+			}
+		}
+		return alpha;
+	}
+
+	// Puts the moves in the order they should be searched and returns how many there are.
+	static int order_moves(uint64_t p, uint64_t o, uint64_t moves, int* squares) {
+		int numEmpty = __builtin_popcountll(~(p | o));
+		if (numEmpty <= 6) {
+			int n = parity_order(~(p | o), squares);
+			// Keeps only the empty squares that are moves.
+			int k = 0;
+			for (int i = 0; i < n; i++) {
+				if ((moves >> squares[i]) & 1) {
+					squares[k++] = squares[i];
+				}
+			}
+			return k;
+		}
+		// Fastest first: the fewer replies a move leaves the opponent, the sooner it is tried.
+		int costs[64];
+		int n = 0;
+		for (; moves; moves &= moves - 1) {
+			int sq = __builtin_ctzll(moves);
+			uint64_t flips = Board::get_flips(sq, p, o);
+			uint64_t newP = p | flips | (1ULL << sq);
+			uint64_t newO = o & ~flips;
+			int cost = __builtin_popcountll(Board::get_moves(newO, newP)) * 2;
+			if ((1ULL << sq) & corners) {
+				cost -= 1;
+			}
+			int i = n++;
+			while (i > 0 && costs[i - 1] > cost) {
+				squares[i] = squares[i - 1];
+				costs[i] = costs[i - 1];
+				i--;
+			}
+			squares[i] = sq;
+			costs[i] = cost;
+		}
+		return n;
+	}
+
+public:
+	// Constructor
+	Endgame_solver()
+	: nodes(0), timedOut(false)
+	{	}
+
+	// Returns the number of positions searched by the last call to best_move.
+	long long nodes_searched() const {
+		return nodes;
+	}
+
+	// Finds the best move for player s, searching every continuation to the end of the game.
+	// Only the result matters (win, draw, or loss), not the margin, which makes the search much faster.
+	// Returns false if there is no move, or the deadline passes before the search finishes.
+	// Otherwise returns true and sets move and result (1 for a win, 0 for a draw, -1 for a loss).
+	bool best_move(const Board& b, Square s, chrono::steady_clock::time_point searchDeadline, Location& move, int& result) {
+		uint64_t p = b.bits(s);
+		uint64_t o = (b.bits(Square::human) | b.bits(Square::computer)) ^ p;
+		uint64_t moves = Board::get_moves(p, o);
+		if (moves == 0) {
+			return false;
+		}
+		nodes = 0;
+		deadline = searchDeadline;
+		timedOut = false;
+
+		int squares[64];
+		int n = order_moves(p, o, moves, squares);
+		int best = -2;
+		for (int i = 0; i < n && best < 1; i++) {
+			uint64_t flips = Board::get_flips(squares[i], p, o);
+			int score = -solve(o & ~flips, p | flips | (1ULL << squares[i]), -1, -max(best, -1), false);
+			if (timedOut) {
+				return false;
+			}
+			score = (score > 0) - (score < 0);
+			if (score > best) {
+				best = score;
+				move = Location{squares[i] / 8, squares[i] % 8};
+			}
+		}
+		result = best;
+		return true;
+	}
+
+}; // Endgame Solver Class
@@ -0,0 +1,271 @@
+// Game_record.h
+
+// Binary game records
+// A record file starts with an 8 byte file header: the letters RVGR, a version byte, and 3 zero bytes.
+// Then come the games, one after another, each made of:
+//  - a 20 byte game header:
+//     bytes 0-1   number of moves (including passes)
+//     byte  2, 3  how player 1 and player 2 made moves (the player types from a5)
+//     byte  4, 5  player 1's and player 2's pieces at the end of the game
+//     byte  6     flags: 1 if the game has search statistics
+//     byte  7     0
+//     bytes 8-15  the seed of the match the game was part of
+//     bytes 16-19 the game's number within the match, which with the seed is enough to replay it
+//  - one byte per move: the square (row * 8 + col), or 64 if the player had to pass. Player 1 moves first.
+//  - if the game has search statistics, 8 bytes per move: the playouts or positions searched and the microseconds taken.
+// Every number is stored little-endian, whatever machine wrote it.
+
+// The search statistics for one move.
+struct Move_stats {
+	// Playouts (MCTS) or positions (alpha-beta) searched to choose the move, or 0 for players that don't search.
+	uint32_t count;
+	uint32_t microseconds;
+};
+
+// A finished game, ready to be written to a record file.
+struct Game_record {
+	uint8_t p1type = 0;
+	uint8_t p2type = 0;
+	uint8_t p1Pieces = 0;
+	uint8_t p2Pieces = 0;
+	uint64_t seed = 0;
+	uint32_t game = 0;
+	// The squares played, or passMove when a player had to pass.
+	vector<uint8_t> moves;
+	// Whether the game has search statistics, one for each move.
+	bool hasStats = false;
+	vector<Move_stats> stats;
+
+	static constexpr uint8_t passMove = 64;
+
+	// Empties the record so it can be used for another game, keeping the memory it has.
+	void clear() {
+		moves.clear();
+		stats.clear();
+	}
+};
+
+static constexpr char recordMagic[4] = {'R', 'V', 'G', 'R'};
+static constexpr uint8_t recordVersion = 1;
+static constexpr int recordFileHeaderSize = 8;
+static constexpr int recordGameHeaderSize = 20;
+static constexpr int recordStatsSize = 8;
+
+// Game record writer class
+// Appends games to a record file through a large buffer, so writing a game is usually just a copy into memory.
+// Several threads can write games through the same writer.
+class Game_record_writer {
+private:
+	FILE* file;
+	vector<uint8_t> buffer;
+	mutex writeLock;
+
+	// Buffers are written out once they get this big.
+	static constexpr size_t bufferSize = 1 << 20;
+
+	// Adds a number to the buffer, least significant byte first.
+	void put(uint64_t n, int bytes) {
+		for (int i = 0; i < bytes; i++) {
+			buffer.push_back(uint8_t(n >> (8 * i)));
+		}
+	}
+
+	// Writes out the buffer. Must be called with writeLock held.
+	void flush_buffer() {
+		if (!buffer.empty() && fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+			cmpt::error("can't write to game record file");
+		}
+		buffer.clear();
+	}
+
+public:
+	// Constructor
+	// Creates a new record file, replacing any file with the same name.
+	Game_record_writer(const string& filename) {
+		file = fopen(filename.c_str(), "wb");
+		if (file == nullptr) {
+			cmpt::error("can't create game record file " + filename);
+		}
+		buffer.reserve(bufferSize + 4096);
+		buffer.insert(buffer.end(), recordMagic, recordMagic + 4);
+		put(recordVersion, 1);
+		put(0, 3);
+	}
+
+	// Destructor
+	// Closes the file if close was not called. A destructor can't report errors by throwing, so they are only printed;
+	// call close to find out whether everything was written.
+	~Game_record_writer() {
+		try {
+			close();
+		} catch (const exception& e) {
+			cerr << "Error: " << e.what() << endl;
+		}
+	}
+
+	Game_record_writer(const Game_record_writer&) = delete;
+	Game_record_writer& operator=(const Game_record_writer&) = delete;
+
+	// Adds a game to the file.
+	void write(const Game_record& record) {
+		lock_guard<mutex> guard(writeLock);
+		put(record.moves.size(), 2);
+		put(record.p1type, 1);
+		put(record.p2type, 1);
+		put(record.p1Pieces, 1);
+		put(record.p2Pieces, 1);
+		put(record.hasStats ? 1 : 0, 1);
+		put(0, 1);
+		put(record.seed, 8);
+		put(record.game, 4);
+		buffer.insert(buffer.end(), record.moves.begin(), record.moves.end());
+		if (record.hasStats) {
+			for (const Move_stats& s : record.stats) {
+				put(s.count, 4);
+				put(s.microseconds, 4);
+			}
+		}
+		if (buffer.size() >= bufferSize) {
+			flush_buffer();
+		}
+	}
+
+	// Writes out whatever is still in the buffer and closes the file. Reports a failure with cmpt::error.
+	// Nothing can be written after this, and closing again does nothing.
+	void close() {
+		lock_guard<mutex> guard(writeLock);
+		if (file == nullptr) {
+			return;
+		}
+		FILE* f = file;
+		file = nullptr;
+		bool written = buffer.empty() || fwrite(buffer.data(), 1, buffer.size(), f) == buffer.size();
+		buffer.clear();
+		// fclose writes out the file's own buffer, so it can fail too.
+		if (fclose(f) != 0 || !written) {
+			cmpt::error("can't write to game record file");
+		}
+	}
+
+	// Writes out the buffer, so everything written so far is in the file.
+	void flush() {
+		lock_guard<mutex> guard(writeLock);
+		flush_buffer();
+		fflush(file);
+	}
+
+}; // Game Record Writer Class
+
+// A game read from a record file.
+// The moves and statistics point straight into the file's memory, so nothing is copied.
+struct Game_view {
+	uint8_t p1type;
+	uint8_t p2type;
+	uint8_t p1Pieces;
+	uint8_t p2Pieces;
+	uint64_t seed;
+	uint32_t game;
+	int numMoves;
+	// The squares played, or Game_record::passMove for a pass.
+	const uint8_t* moves;
+	// The statistics, or nullptr if the game has none. Use get_stats to read them.
+	const uint8_t* stats;
+
+	// Reads a little-endian number.
+	static uint64_t get(const uint8_t* p, int bytes) {
+		uint64_t n = 0;
+		for (int i = 0; i < bytes; i++) {
+			n |= uint64_t(p[i]) << (8 * i);
+		}
+		return n;
+	}
+
+	// Returns the statistics for move i. The game must have statistics.
+	Move_stats get_stats(int i) const {
+		const uint8_t* p = stats + i * recordStatsSize;
+		return Move_stats{uint32_t(get(p, 4)), uint32_t(get(p + 4, 4))};
+	}
+};
+
+// Game record reader class
+// Maps a whole record file into memory and steps through its games without reading or parsing anything up front,
+// so even files with millions of games open instantly and only the pages actually used are read from disk.
+class Game_record_reader {
+private:
+	int fd;
+	const uint8_t* data;
+	size_t size;
+	// Where the next game starts.
+	size_t offset;
+
+public:
+	// Constructor
+	Game_record_reader(const string& filename)
+	: fd(-1), data(nullptr), size(0), offset(recordFileHeaderSize)
+	{
+		fd = open(filename.c_str(), O_RDONLY);
+		if (fd == -1) {
+			cmpt::error("can't open game record file " + filename);
+		}
+		struct stat info;
+		fstat(fd, &info);
+		size = info.st_size;
+		if (size < recordFileHeaderSize) {
+			close(fd);
+			cmpt::error(filename + " is not a game record file");
+		}
+		void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped == MAP_FAILED) {
+			close(fd);
+			cmpt::error("can't map game record file " + filename);
+		}
+		data = static_cast<const uint8_t*>(mapped);
+		// The games are read front to back.
+		madvise(mapped, size, MADV_SEQUENTIAL);
+		if (!equal(recordMagic, recordMagic + 4, data) || data[4] != recordVersion) {
+			munmap(mapped, size);
+			close(fd);
+			cmpt::error(filename + " is not a version " + to_string(recordVersion) + " game record file");
+		}
+	}
+
+	// Destructor
+	~Game_record_reader() {
+		munmap(const_cast<uint8_t*>(data), size);
+		close(fd);
+	}
+
+	Game_record_reader(const Game_record_reader&) = delete;
+	Game_record_reader& operator=(const Game_record_reader&) = delete;
+
+	// Reads the next game into game.
+	// Returns false when there are no games left. A game cut off at the end of the file, e.g. by a crash, is ignored.
+	bool next(Game_view& game) {
+		if (offset + recordGameHeaderSize > size) {
+			return false;
+		}
+		const uint8_t* p = data + offset;
+		game.numMoves = Game_view::get(p, 2);
+		game.p1type = p[2];
+		game.p2type = p[3];
+		game.p1Pieces = p[4];
+		game.p2Pieces = p[5];
+		bool hasStats = p[6] & 1;
+		game.seed = Game_view::get(p + 8, 8);
+		game.game = Game_view::get(p + 16, 4);
+		size_t length = recordGameHeaderSize + game.numMoves * (hasStats ? 1 + recordStatsSize : 1);
+		if (offset + length > size) {
+			return false;
+		}
+		game.moves = p + recordGameHeaderSize;
+		game.stats = hasStats ? game.moves + game.numMoves : nullptr;
+		offset += length;
+		return true;
+	}
+
+	// Goes back to the first game.
+	void rewind() {
+		offset = recordFileHeaderSize;
+	}
+
+}; // Game Record Reader Class
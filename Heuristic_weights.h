@@ -0,0 +1,109 @@
+// Heuristic_weights.h
+
+// Heuristic weights files
+// A text file holding a positional table and the weights get_combined_move gives its heuristics, so they can be
+// changed without recompiling, e.g. to use the weights found by tune. It looks like:
+//   version 1
+//   table
+//   99 -8 8 6 6 8 -8 99
+//   ... (8 rows of 8 values, from row 1 to row 8)
+//   early 1 0.3 0.8 0
+//   late 0.1 0.6 0 4
+//   late_empties 10
+// Blank lines and anything after a # are ignored.
+
+// The version of heuristic weights files this program reads and writes.
+static constexpr int heuristicWeightsVersion = 1;
+
+// A positional table and combined heuristic weights that go together.
+// Boards only point to their table and weights, so these must outlive every board that uses them.
+struct Heuristic_weights {
+	Positional_table table;
+	Combined_weights combined;
+
+	// Constructor
+	// The standard table and weights.
+	Heuristic_weights()
+	: table(standardPositionalTable), combined(standardCombinedWeights)
+	{	}
+
+	// Reads the weights from a file.
+	static Heuristic_weights read(const string& filename) {
+		ifstream in(filename);
+		if (!in) {
+			cmpt::error("can't open heuristic weights file " + filename);
+		}
+		// Reads the whole file as words, leaving out the comments.
+		stringstream words;
+		string line;
+		while (getline(in, line)) {
+			words << line.substr(0, line.find('#')) << '\n';
+		}
+
+		Heuristic_weights w;
+		int version = 0;
+		bool haveTable = false;
+		string name;
+		while (words >> name) {
+			bool ok = true;
+			if (name == "version") {
+				ok = bool(words >> version);
+			} else if (name == "table") {
+				for (int i = 0; i < 64 && ok; i++) {
+					ok = bool(words >> w.table.weights[i]);
+				}
+				haveTable = true;
+			} else if (name == "early" || name == "late") {
+				double* set = (name == "early") ? w.combined.early : w.combined.late;
+				for (int i = 0; i < 4 && ok; i++) {
+					ok = bool(words >> set[i]);
+				}
+			} else if (name == "late_empties") {
+				ok = bool(words >> w.combined.lateEmpties);
+			} else {
+				cmpt::error("unknown setting in " + filename + ": " + name);
+			}
+			if (!ok) {
+				cmpt::error("bad value for " + name + " in " + filename);
+			}
+		}
+		if (version != heuristicWeightsVersion || !haveTable) {
+			cmpt::error(filename + " is not a version " + to_string(heuristicWeightsVersion) + " heuristic weights file");
+		}
+		return w;
+	}
+
+	// Writes the weights to a file that read can read.
+	void save(const string& filename) const {
+		ofstream out(filename);
+		out << "version " << heuristicWeightsVersion << "\n\n";
+		out << "# The positional table, from row 1 to row 8.\n";
+		out << "table\n";
+		for (int r = 0; r < 8; r++) {
+			for (int c = 0; c < 8; c++) {
+				out << setw(5) << table.weights[r * 8 + c];
+			}
+			out << "\n";
+		}
+		out << "\n# The weights of the positional score, opponent's mobility, pieces flipped, and pieces flipped again.\n";
+		out << "early";
+		for (double x : combined.early) {
+			out << " " << x;
+		}
+		out << "\nlate";
+		for (double x : combined.late) {
+			out << " " << x;
+		}
+		out << "\nlate_empties " << combined.lateEmpties << "\n";
+		if (!out) {
+			cmpt::error("can't write heuristic weights file " + filename);
+		}
+	}
+
+	// Makes a board use these weights.
+	void apply(Board& b) const {
+		b.set_positional_table(table);
+		b.set_combined_weights(combined);
+	}
+
+};
@@ -0,0 +1,115 @@
+// Opening_book.h
+
+// Opening books
+// A book file starts with a 16 byte header: the letters RVOB, a version byte, 3 zero bytes, and the number of entries.
+// Then come the entries, one for each position in its canonical form (see Board::canonicalize), sorted by key.
+// Each one is a Book_entry exactly as it is laid out in memory.
+// The file is used straight from memory without being read or checked entry by entry, so a book only works on machines
+// with the same byte order as the one that built it. The header's entry count is stored in that order too,
+// which is how a book from the wrong kind of machine is caught.
+// Books are built from game records by make_book.
+
+// The move to play in one position.
+struct Book_entry {
+	// Board::canonical_key of the position.
+	uint64_t key;
+	// How many recorded games played the move from this position.
+	uint32_t games;
+	// The player to move's average score in those games, from 0 (lost them all) to 10000 (won them all).
+	uint16_t score;
+	// The square to play in the canonical form of the position, row * 8 + col.
+	uint8_t move;
+	uint8_t reserved;
+};
+
+static_assert(sizeof(Book_entry) == 16, "book files hold 16 byte entries");
+
+static constexpr char bookMagic[4] = {'R', 'V', 'O', 'B'};
+static constexpr uint8_t bookVersion = 2;
+static constexpr int bookHeaderSize = 16;
+
+// Opening book class
+// Maps a book file into memory and looks positions up in it by binary search, so loading a book costs nothing
+// however big it is, and the pages of the file are shared by every player that has it open.
+class Opening_book {
+private:
+	int fd;
+	const uint8_t* data;
+	size_t size;
+	const Book_entry* entries;
+	uint64_t numEntries;
+
+	// Finds the entry for a key. Returns nullptr if the position isn't in the book.
+	const Book_entry* find(uint64_t key) const {
+		const Book_entry* end = entries + numEntries;
+		const Book_entry* e = lower_bound(entries, end, key, [](const Book_entry& entry, uint64_t k) {
+			return entry.key < k;
+		});
+		return (e != end && e->key == key) ? e : nullptr;
+	}
+
+public:
+	// Constructor
+	Opening_book(const string& filename)
+	: fd(-1), data(nullptr), size(0), entries(nullptr), numEntries(0)
+	{
+		fd = open(filename.c_str(), O_RDONLY);
+		if (fd == -1) {
+			cmpt::error("can't open opening book " + filename);
+		}
+		struct stat info;
+		fstat(fd, &info);
+		size = info.st_size;
+		if (size < bookHeaderSize) {
+			close(fd);
+			cmpt::error(filename + " is not an opening book");
+		}
+		void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped == MAP_FAILED) {
+			close(fd);
+			cmpt::error("can't map opening book " + filename);
+		}
+		data = static_cast<const uint8_t*>(mapped);
+		memcpy(&numEntries, data + 8, sizeof(numEntries));
+		if (!equal(bookMagic, bookMagic + 4, data) || data[4] != bookVersion
+				|| numEntries != (size - bookHeaderSize) / sizeof(Book_entry)) {
+			munmap(mapped, size);
+			close(fd);
+			cmpt::error(filename + " is not a version " + to_string(bookVersion) + " opening book for this machine");
+		}
+		entries = reinterpret_cast<const Book_entry*>(data + bookHeaderSize);
+	}
+
+	// Destructor
+	~Opening_book() {
+		munmap(const_cast<uint8_t*>(data), size);
+		close(fd);
+	}
+
+	Opening_book(const Opening_book&) = delete;
+	Opening_book& operator=(const Opening_book&) = delete;
+
+	// Returns the number of positions in the book.
+	uint64_t num_entries() const {
+		return numEntries;
+	}
+
+	// Looks up the position on b with turn to move.
+	// The book holds positions in their canonical form (see Board::canonicalize), so the position is turned into
+	// its canonical form to look it up, and the move found is turned back to match b.
+	// Returns true and sets move if the position is in the book.
+	bool find_move(const Board& b, Square turn, Location& move) const {
+		int t;
+		const Book_entry* e = find(b.canonical_key(turn, t));
+		if (e == nullptr) {
+			return false;
+		}
+		int sq = Board::transform_square(e->move, Board::inverse_symmetry(t));
+		if (!(b.get_moves(turn) >> sq & 1)) {
+			return false;
+		}
+		move = Location{sq / 8, sq % 8};
+		return true;
+	}
+
+}; // Opening Book Class
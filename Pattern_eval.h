@@ -0,0 +1,299 @@
+// Pattern_eval.h
+
+// Pattern evaluation
+// Scores a position by looking up each line and corner region of the board in a table, rather than scoring squares
+// one at a time, so the evaluation can tell e.g. a safe edge from one the opponent can take a corner from.
+// Each pattern is a list of up to 10 squares, and its contents are a base 3 number, its code: square i of the pattern
+// adds 3^i times 0 if it is empty, 1 if it holds the player to move's piece, or 2 if it holds the opponent's.
+// Every pattern is one of a few shapes turned to each corner or edge of the board, and all the patterns with the same
+// shape share one table of weights, so the evaluation is the same for positions that are rotations or reflections of each other.
+// The weights change over the game, so there is a set of tables for each phase of the game.
+
+// A shape of pattern, given by its squares in the first corner or edge of the board it is found in.
+struct Pattern_shape {
+	int size;
+	int squares[10];
+};
+
+// Edges, 3x3 and 2x5 corner regions, and the diagonals of length 4 to 8.
+constexpr Pattern_shape patternShapes[] = {
+	{8, {0, 1, 2, 3, 4, 5, 6, 7}},
+	{9, {0, 1, 2, 8, 9, 10, 16, 17, 18}},
+	{10, {0, 1, 2, 3, 4, 8, 9, 10, 11, 12}},
+	{8, {0, 9, 18, 27, 36, 45, 54, 63}},
+	{7, {1, 10, 19, 28, 37, 46, 55}},
+	{6, {2, 11, 20, 29, 38, 47}},
+	{5, {3, 12, 21, 30, 39}},
+	{4, {4, 13, 22, 31}}
+};
+constexpr int numShapes = sizeof(patternShapes) / sizeof(patternShapes[0]);
+
+// Every pattern on the board, and for each square, the patterns it is in.
+// Made at compile time by turning each shape with the board's eight symmetries (see Board::transform)
+// and keeping the ones that cover a set of squares not already used by that shape.
+struct Pattern_layout {
+	static constexpr int maxPatterns = 64;
+	static constexpr int maxPerSquare = 8;
+
+	int numPatterns;
+	int shape[maxPatterns];
+	// Where each pattern's table starts among a phase's weights.
+	int start[maxPatterns];
+	// Where each shape's table starts among a phase's weights, and how many weights a phase has in all.
+	int offset[numShapes];
+	int phaseSize;
+	// The patterns each square is in, and the power of 3 the square's digit has in each of them.
+	int numEntries[64];
+	int entryPattern[64][maxPerSquare];
+	int entryPower[64][maxPerSquare];
+
+	constexpr Pattern_layout()
+	: numPatterns(0), shape(), start(), offset(), phaseSize(0), numEntries(), entryPattern(), entryPower()
+	{
+		uint64_t used[maxPatterns] = {};
+		for (int s = 0; s < numShapes; s++) {
+			offset[s] = phaseSize;
+			int codes = 1;
+			for (int i = 0; i < patternShapes[s].size; i++) {
+				codes *= 3;
+			}
+			phaseSize += codes;
+
+			for (int t = 0; t < 8; t++) {
+				int squares[10] = {};
+				uint64_t mask = 0;
+				for (int i = 0; i < patternShapes[s].size; i++) {
+					// The same as Board::transform_square.
+					int r = patternShapes[s].squares[i] / 8;
+					int c = patternShapes[s].squares[i] % 8;
+					if (t & 4) {
+						int temp = r;
+						r = c;
+						c = temp;
+					}
+					if (t & 2) {
+						r = 7 - r;
+					}
+					if (t & 1) {
+						c = 7 - c;
+					}
+					squares[i] = r * 8 + c;
+					mask |= 1ULL << squares[i];
+				}
+				bool seen = false;
+				for (int p = 0; p < numPatterns; p++) {
+					seen = seen || (shape[p] == s && used[p] == mask);
+				}
+				if (seen) {
+					continue;
+				}
+				int p = numPatterns++;
+				shape[p] = s;
+				start[p] = offset[s];
+				used[p] = mask;
+				int power = 1;
+				for (int i = 0; i < patternShapes[s].size; i++) {
+					int sq = squares[i];
+					entryPattern[sq][numEntries[sq]] = p;
+					entryPower[sq][numEntries[sq]] = power;
+					numEntries[sq]++;
+					power *= 3;
+				}
+			}
+		}
+	}
+};
+
+constexpr Pattern_layout patternLayout;
+
+// Pattern codes class
+// The code of every pattern, kept up to date as moves are made and taken back.
+// Holds two sets of codes, one for each player to move, so neither has to be worked out from the other.
+class Pattern_codes {
+private:
+	// codes[0] has the human player's pieces as 1 and the computer's as 2, codes[1] the other way round.
+	uint16_t codes[2][Pattern_layout::maxPatterns];
+
+	// Changes the digit for square sq in every pattern it is in, by humanDigit in the view where the human's pieces are 1
+	// and by computerDigit in the other.
+	void add(int sq, int humanDigit, int computerDigit) {
+		for (int i = 0; i < patternLayout.numEntries[sq]; i++) {
+			int p = patternLayout.entryPattern[sq][i];
+			int power = patternLayout.entryPower[sq][i];
+			codes[0][p] += humanDigit * power;
+			codes[1][p] += computerDigit * power;
+		}
+	}
+
+public:
+	// Constructor
+	Pattern_codes()
+	: codes()
+	{	}
+
+	// Works out every code from scratch for the position on b.
+	void set(const Board& b) {
+		for (int v = 0; v < 2; v++) {
+			for (int p = 0; p < patternLayout.numPatterns; p++) {
+				codes[v][p] = 0;
+			}
+		}
+		for (uint64_t h = b.bits(Square::human); h; h &= h - 1) {
+			add(__builtin_ctzll(h), 1, 2);
+		}
+		for (uint64_t c = b.bits(Square::computer); c; c &= c - 1) {
+			add(__builtin_ctzll(c), 2, 1);
+		}
+	}
+
+	// Updates the codes for a move made with Board::make_move.
+	void make_move(const Undo_record& record) {
+		bool human = (record.player == Square::human);
+		add(record.square, human ? 1 : 2, human ? 2 : 1);
+		// A flipped piece goes from 2 to 1 in the mover's view and from 1 to 2 in the other.
+		for (uint64_t f = record.flips; f; f &= f - 1) {
+			add(__builtin_ctzll(f), human ? -1 : 1, human ? 1 : -1);
+		}
+	}
+
+	// Updates the codes for a move taken back with Board::undo_move.
+	void undo_move(const Undo_record& record) {
+		bool human = (record.player == Square::human);
+		add(record.square, human ? -1 : -2, human ? -2 : -1);
+		for (uint64_t f = record.flips; f; f &= f - 1) {
+			add(__builtin_ctzll(f), human ? 1 : -1, human ? -1 : 1);
+		}
+	}
+
+	// Returns the code of pattern p with turn as the player to move.
+	int code(int p, Square turn) const {
+		return codes[turn == Square::human ? 0 : 1][p];
+	}
+
+}; // Pattern Codes Class
+
+// Pattern weights files
+// The letters RVPW, a version byte, the number of phases, the number of shapes, and a zero byte,
+// followed by the weights as 16-bit little-endian numbers: every phase in turn, and within each phase,
+// every shape's table in the order of patternShapes, indexed by code.
+
+static constexpr char patternMagic[4] = {'R', 'V', 'P', 'W'};
+static constexpr uint8_t patternVersion = 1;
+
+// Pattern evaluation class
+// Holds the tables of weights and scores positions with them.
+class Pattern_eval {
+private:
+	// The weights for every phase, in the same order as in the file.
+	vector<int16_t> weights;
+
+public:
+	// The number of phases the game is split into by the number of empty squares.
+	static constexpr int numPhases = 4;
+	// Weights are stored in 1/evalScale units, so they can be finer than the scores they add up to.
+	static constexpr int evalScale = 32;
+
+	// Constructor
+	// Makes an evaluator with every weight 0.
+	Pattern_eval()
+	: weights(numPhases * patternLayout.phaseSize)
+	{	}
+
+	// Returns the phase of the game with the given number of empty squares.
+	static int phase(int empties) {
+		return min(empties * numPhases / 61, numPhases - 1);
+	}
+
+	// Constructor
+	// Reads the weights from a file.
+	Pattern_eval(const string& filename)
+	: Pattern_eval()
+	{
+		ifstream in(filename, ios::binary);
+		if (!in) {
+			cmpt::error("can't open pattern weights file " + filename);
+		}
+		uint8_t header[8];
+		in.read(reinterpret_cast<char*>(header), 8);
+		if (!in || !equal(patternMagic, patternMagic + 4, header) || header[4] != patternVersion
+				|| header[5] != numPhases || header[6] != numShapes) {
+			cmpt::error(filename + " is not a version " + to_string(patternVersion) + " pattern weights file for these patterns");
+		}
+		vector<uint8_t> bytes(weights.size() * 2);
+		in.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+		if (!in) {
+			cmpt::error(filename + " is too short");
+		}
+		for (int i = 0; i < weights.size(); i++) {
+			weights[i] = int16_t(bytes[2 * i] | bytes[2 * i + 1] << 8);
+		}
+	}
+
+	// Makes an evaluator that gives the same scores as a positional table, give or take rounding.
+	// Each square's value is shared out evenly between the patterns it is in.
+	static Pattern_eval from_positional_table(const Positional_table& table) {
+		Pattern_eval eval;
+		for (int s = 0; s < numShapes; s++) {
+			const Pattern_shape& shape = patternShapes[s];
+			int codes = 1;
+			for (int i = 0; i < shape.size; i++) {
+				codes *= 3;
+			}
+			for (int code = 0; code < codes; code++) {
+				double value = 0;
+				int rest = code;
+				for (int i = 0; i < shape.size; i++, rest /= 3) {
+					int sq = shape.squares[i];
+					double share = double(table.weights[sq]) / patternLayout.numEntries[sq];
+					value += (rest % 3 == 1) ? share : (rest % 3 == 2) ? -share : 0;
+				}
+				for (int ph = 0; ph < numPhases; ph++) {
+					eval.set_weight(ph, s, code, value);
+				}
+			}
+		}
+		return eval;
+	}
+
+	// Writes the weights to a file.
+	void save(const string& filename) const {
+		ofstream out(filename, ios::binary);
+		uint8_t header[8] = {};
+		copy(patternMagic, patternMagic + 4, header);
+		header[4] = patternVersion;
+		header[5] = numPhases;
+		header[6] = numShapes;
+		out.write(reinterpret_cast<const char*>(header), 8);
+		vector<uint8_t> bytes(weights.size() * 2);
+		for (int i = 0; i < weights.size(); i++) {
+			bytes[2 * i] = uint16_t(weights[i]) & 0xff;
+			bytes[2 * i + 1] = uint16_t(weights[i]) >> 8;
+		}
+		out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+		if (!out) {
+			cmpt::error("can't write pattern weights file " + filename);
+		}
+	}
+
+	// Sets the weight of a code of a shape in a phase, in score units. Values too big to store are clamped.
+	void set_weight(int phase, int shape, int code, double value) {
+		double scaled = round(value * evalScale);
+		weights[phase * patternLayout.phaseSize + patternLayout.offset[shape] + code] = int16_t(max(min(scaled, 32767.0), -32767.0));
+	}
+
+	// Returns the weight of a code of a shape in a phase, in score units.
+	double get_weight(int phase, int shape, int code) const {
+		return double(weights[phase * patternLayout.phaseSize + patternLayout.offset[shape] + code]) / evalScale;
+	}
+
+	// Returns the score of a position for the player to move, given its pattern codes and number of empty squares.
+	int evaluate(const Pattern_codes& codes, Square turn, int empties) const {
+		const int16_t* w = weights.data() + phase(empties) * patternLayout.phaseSize;
+		int sum = 0;
+		for (int p = 0; p < patternLayout.numPatterns; p++) {
+			sum += w[patternLayout.start[p] + codes.code(p, turn)];
+		}
+		return sum / evalScale;
+	}
+
+}; // Pattern Eval Class
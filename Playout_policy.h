@@ -0,0 +1,83 @@
+// Playout_policy.h
+
+// Playout policies decide the moves made in MCTS playouts.
+// Computer_player's play_out and MCTS take the policy as a template parameter, so each policy gets its own
+// compiled playout loop with the move choice inlined into it.
+//
+// A policy is a class with:
+//  - name: how it is described in output,
+//  - usesBoard: whether it needs the whole Board, with its positional scores, or just the two bitboards,
+//  - choose: picks the square to play from the non-empty bitboard of valid moves.
+// If usesBoard is false the playout runs on a copy of the two bitboards, which is much faster, and choose is
+//   static int choose(uint64_t p, uint64_t o, uint64_t moves, bool mine, Random& random)
+// where p is the player to move's pieces, o the opponent's, and mine is true when the player to move is the searching player.
+// If usesBoard is true the moves are made on the Board and taken back at the end of the playout, and choose is
+//   static int choose(Board& b, uint64_t moves, Square turn, Square me, Square opp, Random& random)
+// where me is the searching player and opp their opponent. choose must leave b as it found it.
+
+// Every move is random.
+struct Pure_playout {
+	static constexpr const char* name = "pure";
+	static constexpr bool usesBoard = false;
+
+	static int choose(uint64_t, uint64_t, uint64_t moves, bool, Random& random) {
+		return Board::random_square(moves, random);
+	}
+};
+
+// The searching player's moves use the combined heuristic from Board::get_combined_move, the opponent's are random.
+struct Combined_playout {
+	static constexpr const char* name = "combined";
+	static constexpr bool usesBoard = true;
+
+	static int choose(Board& b, uint64_t moves, Square turn, Square me, Square opp, Random& random) {
+		if (turn != me) {
+			return Board::random_square(moves, random);
+		}
+		Location move = b.get_combined_move(me, opp, random);
+		return move.row * 8 + move.col;
+	}
+};
+
+// How likely Weighted_playout is to pick each square, relative to the others.
+// Each square's value in the standard positional table, shifted so that even the worst squares get a small chance.
+struct Playout_weights {
+	int w[64];
+
+	constexpr Playout_weights()
+	: w()
+	{
+		for (int i = 0; i < 64; i++) {
+			w[i] = max(standardPositionalTable.weights[i] + 25, 1);
+		}
+	}
+};
+
+constexpr Playout_weights playoutWeights;
+
+// A cheap stand-in for the combined heuristic, costing little more than a random move.
+// Both players take a corner whenever they can, and otherwise pick moves at random weighted by playoutWeights.
+struct Weighted_playout {
+	static constexpr const char* name = "weighted";
+	static constexpr bool usesBoard = false;
+
+	static constexpr uint64_t corners = 0x8100000000000081ULL;
+
+	static int choose(uint64_t, uint64_t, uint64_t moves, bool, Random& random) {
+		if (moves & corners) {
+			return Board::random_square(moves & corners, random);
+		}
+		int total = 0;
+		for (uint64_t m = moves; m; m &= m - 1) {
+			total += playoutWeights.w[__builtin_ctzll(m)];
+		}
+		int pick = random.below(total);
+		for (; ; moves &= moves - 1) {
+			int sq = __builtin_ctzll(moves);
+			pick -= playoutWeights.w[sq];
+			if (pick < 0) {
+				return sq;
+			}
+		}
+	}
+};
@@ -0,0 +1,270 @@
+// Search_tree.h
+
+// A single position in the Monte Carlo search tree.
+// Nodes refer to each other by their index in the Search_tree's pool instead of by pointer.
+// The statistics are atomic so that several threads can search the same tree without locking.
+struct Node {
+	// Moves from this position that do not have a child node yet.
+	atomic<uint64_t> untried;
+	// Sum of the playout scores for the player who made the move leading here.
+	atomic<double> wins;
+	// Number of playouts through this node, including ones still in progress.
+	atomic<int> visits;
+	int parent;
+	// Written last when a child is added, so other threads never see a half made child.
+	atomic<int> firstChild;
+	int nextSibling;
+	// The square of the move that led here, or -1 if the player passed.
+	int move;
+	// The player who made the move that led here.
+	Square player;
+	// Set if the player to move has to pass and the pass child has not been made yet.
+	atomic<bool> passPending;
+	// Zobrist hash of the position, with the player to move.
+	uint64_t key;
+};
+
+// Search tree class
+// Holds every node in one preallocated pool so that growing the tree never touches the allocator.
+// Freed nodes are chained together through nextSibling and handed out again before unused pool space.
+// Adding children is guarded by a mutex, everything else a search does to the tree is lock-free.
+class Search_tree {
+private:
+	vector<Node> pool;
+	// Index of the first never-used node in the pool.
+	int used;
+	// Head of the list of freed nodes, or -1 if there are none.
+	int freeHead;
+	int rootIndex;
+	// Held while a child is being added.
+	mutex expandLock;
+
+	// Adds to an atomic double.
+	static void atomic_add(atomic<double>& a, double x) {
+		double cur = a.load(memory_order_relaxed);
+		while (!a.compare_exchange_weak(cur, cur + x, memory_order_relaxed)) { }
+	}
+
+	// Takes a node from the pool and sets it up as a fresh leaf.
+	// Returns -1 if the pool is full.
+	int allocate(int parent, int move, Square player) {
+		int i;
+		if (freeHead != -1) {
+			i = freeHead;
+			freeHead = pool[i].nextSibling;
+		} else if (used < pool.size()) {
+			i = used++;
+		} else {
+			return -1;
+		}
+		Node& n = pool[i];
+		n.untried.store(0, memory_order_relaxed);
+		n.wins.store(0, memory_order_relaxed);
+		n.visits.store(0, memory_order_relaxed);
+		n.parent = parent;
+		n.firstChild.store(-1, memory_order_relaxed);
+		n.nextSibling = -1;
+		n.move = move;
+		n.player = player;
+		n.passPending.store(false, memory_order_relaxed);
+		return i;
+	}
+
+	// Generates the moves available from a node and works out its hash.
+	void initialize(int i, const Board& b, Square turn, Square other) {
+		Node& n = pool[i];
+		n.key = b.hash(turn);
+		uint64_t moves = b.get_moves(turn);
+		n.untried.store(moves, memory_order_relaxed);
+		n.passPending.store(moves == 0 && b.move_exists(other), memory_order_relaxed);
+	}
+
+public:
+	// Constructor
+	// Allocates room for the given number of nodes up front.
+	Search_tree(int capacity)
+	: pool(capacity), used(0), freeHead(-1), rootIndex(-1)
+	{	}
+
+	// Returns a node in the pool.
+	Node& operator[](int i) {
+		return pool[i];
+	}
+
+	const Node& operator[](int i) const {
+		return pool[i];
+	}
+
+	// Returns the index of the root node.
+	int root() const {
+		return rootIndex;
+	}
+
+	// Returns the number of nodes that can be held at once.
+	int capacity() const {
+		return pool.size();
+	}
+
+	// Throws away the whole tree and starts a new one at position b with turn to move.
+	// The root counts as having been reached by a move from the other player.
+	void reset(const Board& b, Square turn, Square other) {
+		used = 0;
+		freeHead = -1;
+		rootIndex = allocate(-1, -1, other);
+		initialize(rootIndex, b, turn, other);
+	}
+
+	// Returns a node and everything below it to the pool.
+	// Must not be called while a search is running.
+	void free_subtree(int i) {
+		int c = pool[i].firstChild.load(memory_order_relaxed);
+		while (c != -1) {
+			int next = pool[c].nextSibling;
+			free_subtree(c);
+			c = next;
+		}
+		pool[i].nextSibling = freeHead;
+		freeHead = i;
+	}
+
+	// Makes a node in the tree the new root, keeping its statistics and everything below it.
+	// The rest of the old tree is freed.
+	// Must not be called while a search is running.
+	void promote(int i) {
+		Node& parent = pool[pool[i].parent];
+		// Unlinks the node from its parent's list of children.
+		if (parent.firstChild.load(memory_order_relaxed) == i) {
+			parent.firstChild.store(pool[i].nextSibling, memory_order_relaxed);
+		} else {
+			int c = parent.firstChild.load(memory_order_relaxed);
+			while (pool[c].nextSibling != i) {
+				c = pool[c].nextSibling;
+			}
+			pool[c].nextSibling = pool[i].nextSibling;
+		}
+		free_subtree(rootIndex);
+		pool[i].parent = -1;
+		pool[i].nextSibling = -1;
+		rootIndex = i;
+	}
+
+	// Returns true if a node still has moves to expand.
+	bool can_expand(int i) const {
+		return pool[i].untried.load(memory_order_relaxed) != 0
+			|| pool[i].passPending.load(memory_order_relaxed);
+	}
+
+	// Returns the first child of a node, or -1 if it has none.
+	int first_child(int i) const {
+		return pool[i].firstChild.load(memory_order_acquire);
+	}
+
+	// Adds a child for one of the node's untried moves, makes that move on b, and returns the child's index.
+	// Returns -1 and leaves b alone if the pool is full or another thread already took the last untried move.
+	int expand(int i, Board& b, Square turn, Square other) {
+		lock_guard<mutex> guard(expandLock);
+		Node& n = pool[i];
+		uint64_t untried = n.untried.load(memory_order_relaxed);
+		if (untried == 0 && !n.passPending.load(memory_order_relaxed)) {
+			return -1;
+		}
+		int move = (untried != 0) ? __builtin_ctzll(untried) : -1;
+		int child = allocate(i, move, turn);
+		if (child == -1) {
+			return -1;
+		}
+		if (move == -1) {
+			n.passPending.store(false, memory_order_relaxed);
+		} else {
+			n.untried.store(untried & (untried - 1), memory_order_relaxed);
+			b.make_move(Location{move / 8, move % 8}, turn);
+		}
+		initialize(child, b, other, turn);
+		pool[child].nextSibling = n.firstChild.load(memory_order_relaxed);
+		n.firstChild.store(child, memory_order_release);
+		return child;
+	}
+
+	// Picks the child with the highest UCB1 value.
+	// Children that have never been visited are always tried first.
+	// Playouts still in progress count as losses, which steers other threads towards different children.
+	// If a transposition table is given, a child's win rate comes from every playout through its position,
+	// including ones that reached it by a different move order.
+	int select_child(int i, double exploration, const Transposition_table* table) const {
+		double logVisits = log(pool[i].visits.load(memory_order_relaxed));
+		int best = -1;
+		double bestValue = -1;
+		for (int c = first_child(i); c != -1; c = pool[c].nextSibling) {
+			const Node& n = pool[c];
+			int visits = n.visits.load(memory_order_relaxed);
+			if (visits == 0) {
+				return c;
+			}
+			double winRate = n.wins.load(memory_order_relaxed) / visits;
+			uint64_t payload;
+			int depth;
+			if (table != nullptr && table->probe(n.key, payload, depth)) {
+				Playout_entry e = Playout_entry::unpack(payload);
+				if (e.visits > 0) {
+					winRate = e.halfWins / (2.0 * e.visits);
+				}
+			}
+			double value = winRate + exploration * sqrt(logVisits / visits);
+			if (value > bestValue) {
+				bestValue = value;
+				best = c;
+			}
+		}
+		return best;
+	}
+
+	// Counts a playout as passing through a node before its result is known.
+	void add_visit(int i) {
+		pool[i].visits.fetch_add(1, memory_order_relaxed);
+	}
+
+	// Adds a playout result to a node and every node above it.
+	// The visits were already counted on the way down.
+	// The result is from the point of view of player s, so it is flipped for nodes reached by the other player.
+	// If a transposition table is given, the result is also added to each position's entry in it.
+	void backpropagate(int i, double result, Square s, Transposition_table* table) {
+		while (i != -1) {
+			Node& n = pool[i];
+			double score = (n.player == s) ? result : 1 - result;
+			atomic_add(n.wins, score);
+			if (table != nullptr) {
+				// Updated in place, so playouts backed up by other threads at the same time are not lost.
+				table->update(n.key, [score](uint64_t& payload, int& depth) {
+					Playout_entry e = Playout_entry::unpack(payload);
+					e.visits++;
+					e.halfWins += int(score * 2);
+					payload = e.pack();
+					depth = e.depth();
+				});
+			}
+			i = n.parent;
+		}
+	}
+
+	// Returns the child of a node reached by a move, or -1 if there is none.
+	int find_child(int i, int move) const {
+		for (int c = first_child(i); c != -1; c = pool[c].nextSibling) {
+			if (pool[c].move == move) {
+				return c;
+			}
+		}
+		return -1;
+	}
+
+	// Returns the most visited child of a node.
+	int most_visited_child(int i) const {
+		int best = -1;
+		for (int c = first_child(i); c != -1; c = pool[c].nextSibling) {
+			if (best == -1 || pool[c].visits > pool[best].visits) {
+				best = c;
+			}
+		}
+		return best;
+	}
+
+}; // Search Tree Class
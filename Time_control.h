@@ -0,0 +1,128 @@
+// Time_control.h
+
+// How much a search may do before it has to choose a move.
+struct Search_budget {
+	// When the search has to stop.
+	chrono::steady_clock::time_point deadline;
+	// When the endgame solver has to give up, leaving the rest of the time for a normal search.
+	chrono::steady_clock::time_point solverDeadline;
+	// The most playouts (MCTS) or positions (alpha-beta) to search, or 0 for no limit.
+	long long maxCount;
+	// If not 0, MCTS also stops once it has made this many playouts per valid move.
+	int playoutsPerMove;
+	// The deepest alpha-beta searches.
+	int maxDepth;
+};
+
+// The ways a player's thinking can be limited.
+//  standard: 250 playouts per valid move for MCTS, or 8 moves deep for alpha-beta, or a time limit, whichever comes first.
+//  fixed_time: always searches for the same time.
+//  fixed_nodes and fixed_playouts: searches a set number of playouts (MCTS) or positions (alpha-beta), however long it takes.
+//   For MCTS the two are the same thing, as every playout adds one node to the tree.
+//  game_clock: has a total time for the whole game, plus an increment for every move made, and shares it out between the moves.
+enum class Time_mode {
+	standard, fixed_time, fixed_nodes, fixed_playouts, game_clock
+};
+
+// Time control class
+// Works out a Search_budget for each move, and keeps the game clock.
+class Time_control {
+private:
+	Time_mode mode;
+	// The time per move, or for the whole game with a game clock.
+	double seconds;
+	// The number of nodes or playouts per move.
+	long long count;
+	double increment;
+	// The time left on the game clock.
+	double remaining;
+
+	// Time kept back on the game clock for the moves still to come, as the last moves can take longer than planned.
+	static constexpr double reserveSeconds = 0.05;
+	// The least time a move gets from the game clock, even once the clock is down to the reserve.
+	static constexpr double minMoveSeconds = 0.001;
+
+	// Constructor
+	Time_control(Time_mode m, double s, long long c, double inc)
+	: mode(m), seconds(s), count(c), increment(inc), remaining(s)
+	{	}
+
+	static chrono::steady_clock::duration to_duration(double s) {
+		return chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(s));
+	}
+
+public:
+	// Constructor
+	// The standard limits with 5 seconds per move.
+	Time_control()
+	: Time_control(Time_mode::standard, 5, 0, 0)
+	{	}
+
+	static Time_control standard(double seconds) {
+		return Time_control(Time_mode::standard, seconds, 0, 0);
+	}
+
+	static Time_control fixed_time(double seconds) {
+		return Time_control(Time_mode::fixed_time, seconds, 0, 0);
+	}
+
+	static Time_control fixed_nodes(long long nodes) {
+		return Time_control(Time_mode::fixed_nodes, 0, nodes, 0);
+	}
+
+	static Time_control fixed_playouts(long long playouts) {
+		return Time_control(Time_mode::fixed_playouts, 0, playouts, 0);
+	}
+
+	static Time_control game_clock(double seconds, double increment) {
+		return Time_control(Time_mode::game_clock, seconds, 0, increment);
+	}
+
+	Time_mode get_mode() const {
+		return mode;
+	}
+
+	// Returns the time left on the game clock.
+	double seconds_left() const {
+		return remaining;
+	}
+
+	// Puts the game clock back to its starting time.
+	void new_game() {
+		remaining = seconds;
+	}
+
+	// Works out the budget for a move that starts now, in a position with the given number of empty squares.
+	// With a game clock, each move gets an even share of the time left over the moves the player probably still has to make,
+	// plus the increment, and never less than minMoveSeconds.
+	Search_budget start_move(int empties) const {
+		auto now = chrono::steady_clock::now();
+		auto never = chrono::steady_clock::time_point::max();
+		Search_budget budget{never, never, 0, 0, 60};
+		if (mode == Time_mode::fixed_nodes || mode == Time_mode::fixed_playouts) {
+			budget.maxCount = count;
+			return budget;
+		}
+
+		double moveSeconds = seconds;
+		if (mode == Time_mode::game_clock) {
+			double available = max(remaining - reserveSeconds, 0.0);
+			int movesLeft = empties / 2 + 1;
+			moveSeconds = max(min(available / movesLeft + increment, available), minMoveSeconds);
+		} else if (mode == Time_mode::standard) {
+			budget.playoutsPerMove = 250;
+			budget.maxDepth = 8;
+		}
+		budget.deadline = now + to_duration(moveSeconds);
+		budget.solverDeadline = now + to_duration(moveSeconds / 2);
+		return budget;
+	}
+
+	// Takes the time a move took off the game clock and adds the increment.
+	void end_move(double secondsUsed) {
+		if (mode == Time_mode::game_clock) {
+			remaining += increment - secondsUsed;
+		}
+	}
+
+}; // Time Control Class
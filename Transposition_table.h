@@ -0,0 +1,186 @@
+// Transposition_table.h
+
+// One slot of the transposition table.
+// The data and the key XORed with the data are stored as two separate atomic words,
+// so if two threads write the slot at the same time the mismatch is caught when it is read
+// and the slot is treated as empty, without needing a lock.
+struct Table_slot {
+	atomic<uint64_t> check;
+	atomic<uint64_t> data;
+};
+
+// Transposition table class
+// A fixed-size hash table of positions, keyed by Zobrist hash, that any search can use to
+// remember what it found out about a position and recognize it when it is reached by a different move order.
+// Each slot holds 48 bits of data for the search to use as it likes, plus a depth and the search it came from.
+// When two positions land on the same slot, the one that is worth more (the greater depth) is kept,
+// unless the stored one is left over from an earlier search.
+class Transposition_table {
+private:
+	vector<Table_slot> slots;
+	uint64_t mask;
+	// Counts up every search, so entries from earlier searches can be told apart.
+	uint8_t generation;
+	// Set by store, so clear can skip a table that is already empty.
+	atomic<bool> written;
+
+	static constexpr uint64_t payloadMask = (1ULL << 48) - 1;
+	// Put in a slot's check word by update while it changes the slot, so other updates of the slot wait for it.
+	// probe sees it as a mismatch, so the slot reads as empty for that moment.
+	static constexpr uint64_t lockedCheck = ~0ULL;
+
+	// Returns the data word for a payload and depth stored in the current search.
+	uint64_t pack(uint64_t payload, int depth) const {
+		return (uint64_t(depth) << 56) | (uint64_t(generation) << 48) | (payload & payloadMask);
+	}
+
+public:
+	// Constructor
+	// Makes a table with 2^bits slots.
+	Transposition_table(int bits)
+	: slots(1ULL << bits), mask((1ULL << bits) - 1), generation(0), written(true)
+	{
+		clear();
+	}
+
+	// Empties the table. Does nothing if nothing has been stored since it was last emptied.
+	void clear() {
+		if (!written.load(memory_order_relaxed)) {
+			return;
+		}
+		written.store(false, memory_order_relaxed);
+		for (Table_slot& slot : slots) {
+			slot.check.store(0, memory_order_relaxed);
+			slot.data.store(0, memory_order_relaxed);
+		}
+	}
+
+	// Marks the start of a new search. Entries from older searches are replaced first.
+	void new_search() {
+		generation++;
+	}
+
+	// Looks up a position.
+	// Returns true and fills in the stored data and depth if the position is in the table.
+	bool probe(uint64_t key, uint64_t& payload, int& depth) const {
+		const Table_slot& slot = slots[key & mask];
+		uint64_t data = slot.data.load(memory_order_relaxed);
+		if ((slot.check.load(memory_order_relaxed) ^ data) != key || data == 0) {
+			return false;
+		}
+		payload = data & payloadMask;
+		depth = data >> 56;
+		return true;
+	}
+
+	// Stores data for a position.
+	// Replaces what is in the slot if it is the same position, is from an older search, or has a depth no greater than this one.
+	// The payload must fit in 48 bits and the depth in 0 to 255.
+	void store(uint64_t key, uint64_t payload, int depth) {
+		Table_slot& slot = slots[key & mask];
+		uint64_t old = slot.data.load(memory_order_relaxed);
+		bool samePosition = (slot.check.load(memory_order_relaxed) ^ old) == key;
+		int oldDepth = old >> 56;
+		uint8_t oldGeneration = (old >> 48) & 0xff;
+		if (old != 0 && !samePosition && oldGeneration == generation && oldDepth > depth) {
+			return;
+		}
+		uint64_t data = pack(payload, depth);
+		if (!written.load(memory_order_relaxed)) {
+			written.store(true, memory_order_relaxed);
+		}
+		slot.data.store(data, memory_order_relaxed);
+		slot.check.store(key ^ data, memory_order_relaxed);
+	}
+
+	// Changes the data for a position in place, with no other update of the slot in between, so none are lost
+	// when several threads update the same position at once.
+	// change is called with the stored payload and depth, or 0 and 0 if the position is not in the table,
+	// and changes them to the ones to store. They replace what is in the slot by the same rules as store.
+	// Only other updates wait for one in progress, so update must not be mixed with store on a table several threads are using.
+	template<class Change>
+	void update(uint64_t key, Change change) {
+		Table_slot& slot = slots[key & mask];
+		if (!written.load(memory_order_relaxed)) {
+			written.store(true, memory_order_relaxed);
+		}
+		while (true) {
+			uint64_t check = slot.check.load(memory_order_acquire);
+			if (check == lockedCheck) {
+				this_thread::yield();
+				continue;
+			}
+			// Takes the slot by swapping its check word for lockedCheck, which fails if another update got there first.
+			if (!slot.check.compare_exchange_weak(check, lockedCheck, memory_order_acquire, memory_order_relaxed)) {
+				continue;
+			}
+			uint64_t old = slot.data.load(memory_order_relaxed);
+			bool samePosition = (check ^ old) == key && old != 0;
+			uint64_t payload = samePosition ? (old & payloadMask) : 0;
+			int depth = samePosition ? int(old >> 56) : 0;
+			change(payload, depth);
+
+			int oldDepth = old >> 56;
+			uint8_t oldGeneration = (old >> 48) & 0xff;
+			if (old != 0 && !samePosition && oldGeneration == generation && oldDepth > depth) {
+				// Puts the slot back as it was.
+				slot.check.store(check, memory_order_release);
+				return;
+			}
+			uint64_t data = pack(payload, depth);
+			slot.data.store(data, memory_order_relaxed);
+			slot.check.store(key ^ data, memory_order_release);
+			return;
+		}
+	}
+
+}; // Transposition Table Class
+
+// What an alpha-beta search stores about a position.
+// The score is exact, or only a lower or upper bound if the search was cut off.
+enum class Bound : uint8_t {
+	exact, lower, upper
+};
+
+struct Search_entry {
+	int score;
+	Bound bound;
+	// The best move found, or -1 if there was none.
+	int move;
+
+	// Packs the entry into a table payload.
+	uint64_t pack() const {
+		return (uint64_t(uint32_t(score)) << 16) | (uint64_t(bound) << 8) | uint64_t(move + 1);
+	}
+
+	static Search_entry unpack(uint64_t payload) {
+		return Search_entry{int(uint32_t(payload >> 16)), Bound((payload >> 8) & 0xff), int(payload & 0xff) - 1};
+	}
+};
+
+// What MCTS stores about a position: every playout that has passed through it, whichever path it was reached by.
+// Wins are kept in half points so draws fit in an integer.
+struct Playout_entry {
+	uint32_t visits;
+	uint32_t halfWins;
+
+	// Packs the entry into a table payload, halving both counts if they get too big to fit.
+	uint64_t pack() const {
+		uint64_t v = visits;
+		uint64_t w = halfWins;
+		while (v >= (1ULL << 24) || w >= (1ULL << 24)) {
+			v /= 2;
+			w /= 2;
+		}
+		return (v << 24) | w;
+	}
+
+	static Playout_entry unpack(uint64_t payload) {
+		return Playout_entry{uint32_t(payload >> 24), uint32_t(payload & 0xffffff)};
+	}
+
+	// The depth used to decide which position keeps a slot: positions with more playouts are worth more.
+	int depth() const {
+		return visits == 0 ? 0 : 64 - __builtin_clzll(visits);
+	}
+};
@@ -5,16 +5,42 @@
 using namespace std;
 
 #include <cstdlib>
+#include <cstdint>
 #include <ctime>
 #include <string>
 #include <vector>
 #include <unistd.h>
 #include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <type_traits>
+#include <climits>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cstring>
 
 #include "cmpt_error.h"
+#include "Random.h"
 #include "Board.h"
 #include "Player.h"
+#include "Transposition_table.h"
+#include "Search_tree.h"
+#include "Endgame_solver.h"
+#include "Time_control.h"
+#include "Playout_policy.h"
+#include "Opening_book.h"
+#include "Pattern_eval.h"
+#include "Heuristic_weights.h"
+#include "Game_record.h"
 #include "Human_player.h"
 #include "Computer_player.h"
 
@@ -30,105 +56,211 @@ void welcome() {
 	cout << "Select 1 to play, or 2 to watch: ";
 }
 
-// This vector of vectors contains the positional evaluation table that determines
-// how much controlling each square on the board is worth.
-vector<vector<int>> get_positional_table() {
-	vector<vector<int>> db;
-	vector<int> r1 = {99,  -8,  8,  6,  6,  8,  -8, 99};
-	vector<int> r2 = {-8, -24, -4, -3, -3, -4, -24, -8};
-	vector<int> r3 = { 8,  -4,  7,  4,  4,  7,  -4,  8};
-	vector<int> r4 = { 6,  -3,  4,  0,  0,  4,  -3,  6};
-	vector<int> r5 = r4;
-	vector<int> r6 = r3;
-	vector<int> r7 = r2;
-	vector<int> r8 = r1;
-
-	db.push_back(r1);
-	db.push_back(r2);
-	db.push_back(r3);
-	db.push_back(r4);
-	db.push_back(r5);
-	db.push_back(r6);
-	db.push_back(r7);
-	db.push_back(r8);
-
-	return db;
+// Picks a CPU player's move using the method the user chose at the beginning.
+Location get_CPU_move(int ptype, Computer_player& player, Board& gameBoard) {
+	if (ptype == 3) {
+		return player.MCTS<Pure_playout>(gameBoard);
+	} else if (ptype == 2) {
+		return player.greedy_move(gameBoard);
+	} else if (ptype == 4) {
+		return player.MCTS<Combined_playout>(gameBoard);
+	} else if (ptype == 5) {
+		return player.alpha_beta(gameBoard);
+	} else if (ptype == 6) {
+		return player.MCTS<Weighted_playout>(gameBoard);
+	} else {
+		return player.random_move(gameBoard);
+	}
+}
+
+// Makes a CPU player's move, if it has one, and adds it to the record if there is one.
+// Returns false if the player had to pass.
+bool play_CPU_move(Board& gameBoard, Computer_player& player, int ptype, Game_record* record) {
+	if (!gameBoard.move_exists(player.ID())) {
+		if (record != nullptr) {
+			record->moves.push_back(Game_record::passMove);
+			record->stats.push_back(Move_stats{0, 0});
+		}
+		return false;
+	}
+	auto start = chrono::steady_clock::now();
+	Location move = get_CPU_move(ptype, player, gameBoard);
+	auto end = chrono::steady_clock::now();
+	gameBoard.make_move(move, player.ID());
+
+	if (record != nullptr) {
+		record->moves.push_back(move.row * 8 + move.col);
+		long long count = 0;
+		if (ptype == 3 || ptype == 4 || ptype == 6) {
+			count = player.playouts_searched();
+		} else if (ptype == 5) {
+			count = player.nodes_searched();
+		}
+		long long microseconds = chrono::duration_cast<chrono::microseconds>(end - start).count();
+		record->stats.push_back(Move_stats{uint32_t(min(count, (long long)UINT32_MAX)), uint32_t(min(microseconds, (long long)UINT32_MAX))});
+	}
+	return true;
+}
+
+// Plays a single game between two CPU players until neither can move.
+// Player 1 always moves first.
+// If record is not null the moves are added to it, and the final score is filled in at the end.
+void play_CPU_game(Board& gameBoard, Computer_player& player1, Computer_player& player2, int p1type, int p2type,
+		Game_record* record = nullptr) {
+	int lostTurns = 0;
+	while (lostTurns < 2) {
+		// Player 1 moves, or loses their turn if no move is possible.
+		lostTurns = play_CPU_move(gameBoard, player1, p1type, record) ? 0 : lostTurns + 1;
+		// If neither player can make moves consecutively the game is over.
+		if (lostTurns == 2) {
+			break;
+		}
+		lostTurns = play_CPU_move(gameBoard, player2, p2type, record) ? 0 : lostTurns + 1;
+	}
+
+	if (record != nullptr) {
+		// The passes that ended the game are left out, as the game is over once neither player can move.
+		while (!record->moves.empty() && record->moves.back() == Game_record::passMove) {
+			record->moves.pop_back();
+			record->stats.pop_back();
+		}
+		record->p1type = p1type;
+		record->p2type = p2type;
+		record->p1Pieces = gameBoard.num_pieces(player1.ID());
+		record->p2Pieces = gameBoard.num_pieces(player2.ID());
+	}
+}
+
+// Prints how a CPU player made its moves.
+void print_player_type(int ptype) {
+	if (ptype == 1) {
+		cout << "random moves." << endl;
+	} else if (ptype == 2) {
+		cout << "greedy heuristic moves." << endl;
+	} else if (ptype == 3) {
+		cout << "pure Monte Carlo tree search." << endl;
+	} else if (ptype == 4) {
+		cout << "heuristic Monte Carlo tree search." << endl;
+	} else if (ptype == 5) {
+		cout << "alpha-beta search." << endl;
+	} else if (ptype == 6) {
+		cout << "Monte Carlo tree search with fast weighted playouts." << endl;
+	}
+}
+
+
+// How the program should run, chosen either at the prompts or on the command line.
+struct Game_settings {
+	// True to watch two CPU players, false to play against one.
+	bool watch = true;
+	// How each CPU player makes moves (see print_player_type), or 0 if not chosen yet.
+	int p1type = 0;
+	int p2type = 0;
+	int max_games = 1;
+	// How many games are played at once.
+	int num_workers = 1;
+	// How many threads each CPU player searches with.
+	int search_threads = 1;
+	// How the search threads share the work.
+	Parallel_mode parallel_mode = Parallel_mode::tree;
+	// How many empty squares there must be at most before the CPU players solve the rest of the game exactly. 0 turns it off.
+	int endgame_empties = 20;
+	// How long a CPU player can take to choose a move.
+	Time_control time_control;
+	// Seeds the CPU players' random numbers. 0 picks a new seed from the time.
+	uint64_t seed = 0;
+	// Whether the final board of every game is shown when the games are played one at a time.
+	bool show_games = true;
+	// The file to record the games in, or empty to not record them.
+	string record_file;
+	// Whether the records include how much each move was searched and how long it took.
+	bool record_stats = false;
+	// The opening book for the CPU players' searches, or empty for none.
+	string book_file;
+	// The pattern weights alpha-beta scores positions with, shared by every CPU player, or null to use the positional table.
+	shared_ptr<const Pattern_eval> patterns;
+	// The positional table and combined heuristic weights every board uses, or null for the standard ones.
+	shared_ptr<const Heuristic_weights> weights;
+};
+
+// Makes a game board use the weights the settings ask for.
+void setup_board(Board& gameBoard, const Game_settings& settings) {
+	if (settings.weights != nullptr) {
+		settings.weights->apply(gameBoard);
+	}
+}
+
+// Sets up a CPU player the way the settings ask for.
+void setup_player(Computer_player& player, const Game_settings& settings) {
+	player.set_time_control(settings.time_control);
+	player.set_threads(settings.search_threads, settings.parallel_mode);
+	player.set_endgame_empties(settings.endgame_empties);
+	if (!settings.book_file.empty()) {
+		player.load_opening_book(settings.book_file);
+	}
+	player.set_pattern_eval(settings.patterns);
+}
+
+// Seeds both CPU players for one game of a match.
+// Every game gets its own seeds worked out from the match seed, so any game can be replayed on its own,
+// whichever order the games were played in.
+void seed_players(uint64_t seed, int game, Computer_player& player1, Computer_player& player2) {
+	player1.new_game(seed + 2 * uint64_t(game));
+	player2.new_game(seed + 2 * uint64_t(game) + 1);
+}
+
+// Opens the file the settings ask for the games to be recorded in, if any.
+unique_ptr<Game_record_writer> open_record_file(const Game_settings& settings) {
+	if (settings.record_file.empty()) {
+		return nullptr;
+	}
+	return make_unique<Game_record_writer>(settings.record_file);
+}
+
+// Gets a record ready for a new game, or returns null if the games aren't being recorded.
+Game_record* start_record(Game_record& record, Game_record_writer* writer, const Game_settings& settings, int game) {
+	if (writer == nullptr) {
+		return nullptr;
+	}
+	record.clear();
+	record.seed = settings.seed;
+	record.game = game;
+	record.hasStats = settings.record_stats;
+	return &record;
 }
 
 // For when two CPU players play against each other.
-void CPU_play(int p1type, int p2type, int max_games) {
-	// Set up the board, positional value table, and computer players.
+void CPU_play(const Game_settings& settings) {
+	// Set up the board and computer players.
+	// The board uses the standard positional value table.
 	Board gameBoard;
-	gameBoard.set_positional_table(get_positional_table());
+	setup_board(gameBoard, settings);
 
 	Computer_player player1;
 	player1.invert_pieces();
 	Computer_player player2;
+	setup_player(player1, settings);
+	setup_player(player2, settings);
 
-	Location player1Move;
-	Location player2Move;
-
-	bool gameStillGoing = true;
 	int num_games = 0;
-	int lostTurns = 0;
 	double player2_score = 0;
 	int wins = 0;
 	int draws = 0;
 	int losses = 0;
 
+	unique_ptr<Game_record_writer> writer = open_record_file(settings);
+	Game_record record;
+
 	// Play as many games as the user specifies.
-	while (num_games < max_games) {
+	while (num_games < settings.max_games) {
 		cout << "Game Number: " << num_games + 1 << endl;
-		while (gameStillGoing) {
-
-			// If player 1 can make a move...
-			if (gameBoard.move_exists(player1.ID())){
-				// Selects the move based on the user's choice at the beginning.
-				if (p1type == 3) {
-					player1Move = player1.MCTS(gameBoard, "pure");
-				} else if (p1type == 2) {
-					player1Move = gameBoard.get_combined_move(player1.ID(), player2.ID());
-				} else if (p1type == 4) {
-					player1Move = player1.MCTS(gameBoard, "combined");
-				} else {
-					player1Move = gameBoard.get_random_move(player1.ID());
-				}
-				// Makes the move.
-				gameBoard.make_move(player1Move, player1.ID());
-				lostTurns = 0;
-			} else { // If no move possible...
-				lostTurns++;
-			}
-			
-			if (lostTurns == 2) {
-			// If neither player can make moves consecutively the game is over.
-				gameStillGoing = false;
-				break;
-			}
-
-			// If player 2 can make a move...
-			if (gameBoard.move_exists(player2.ID())) {
-				// Selects the move based on the user's choice at the beginning.
-				if (p2type == 3) {
-					player2Move = player2.MCTS(gameBoard, "pure");
-				} else if (p2type == 2) {
-					player2Move = gameBoard.get_combined_move(player2.ID(), player1.ID());
-				} else if (p2type == 4) {
-					player2Move = player2.MCTS(gameBoard, "combined");
-				} else {
-					player2Move = gameBoard.get_random_move(player2.ID());
-				}
-				// Update the game board.
-				gameBoard.make_move(player2Move, player2.ID());
-				lostTurns = 0;
-			} else { // If player 2 cannot make a move...
-				lostTurns++;
-			}
-			// If neither player can make moves consecutively the game is over.
-			if (lostTurns == 2) {
-				gameStillGoing = false;
-			}
+		seed_players(settings.seed, num_games, player1, player2);
+		Game_record* current = start_record(record, writer.get(), settings, num_games);
+		play_CPU_game(gameBoard, player1, player2, settings.p1type, settings.p2type, current);
+		if (current != nullptr) {
+			writer->write(record);
 		}
+
 		// Print the results of the game.
 		gameBoard.println();
 		gameBoard.print_results();
@@ -145,43 +277,432 @@ void CPU_play(int p1type, int p2type, int max_games) {
 			draws++;
 		}
 
-		lostTurns = 0;
 		gameBoard.clear_board();
-		gameStillGoing = true;
-
+	}
+	if (writer != nullptr) {
+		writer->close();
 	}
 
 	// Print the results of all the games.
 	cout << "Thank you for playing " << num_games << " games!" << endl << endl;
 
-	cout << "Player 2 won " << wins << " times, tied " << draws << " times, and lost " << losses << " times during " << num_games << " games." << endl << endl;
+	cout << "Player 2 won " << wins << " times, tied " << draws << " times, and lost " << losses << " times during " << num_games << " games." << endl;
+	cout << "Random seed: " << settings.seed << endl << endl;
 
 	cout << "Player 1 played using ";
-	if (p1type == 1) {
-		cout << "random moves." << endl;
-	} else if (p1type == 2) {
-		cout << "greedy heuristic moves." << endl;
-	} else if (p1type == 3) {
-		cout << "pure Monte Carlo tree search." << endl;
-	} else if (p1type == 4) {
-		cout << "heuristic Monte Carlo tree search." << endl;
+	print_player_type(settings.p1type);
+
+	cout << "Player 2 played using ";
+	print_player_type(settings.p2type);
+}
+
+// Keeps track of the results of the games played by one worker in a tournament.
+// Each worker has its own copy, padded to a separate cache line so workers never write to shared memory.
+struct alignas(64) Tournament_results {
+	int wins = 0;
+	int draws = 0;
+	int losses = 0;
+	// Player 2's pieces minus player 1's pieces, summed over every game.
+	long long pieceDifference = 0;
+};
+
+// Plays games for a tournament until every game has been claimed by a worker.
+// Each worker has its own board and CPU players, so the only things workers share are the game counter and the record file.
+void tournament_worker(const Game_settings& settings, atomic<int>& next_game, Tournament_results& results,
+		Game_record_writer* writer) {
+	Board gameBoard;
+	setup_board(gameBoard, settings);
+
+	Computer_player player1;
+	player1.invert_pieces();
+	Computer_player player2;
+	setup_player(player1, settings);
+	setup_player(player2, settings);
+
+	Game_record record;
+	int game;
+	while ((game = next_game.fetch_add(1)) < settings.max_games) {
+		seed_players(settings.seed, game, player1, player2);
+		Game_record* current = start_record(record, writer, settings, game);
+		play_CPU_game(gameBoard, player1, player2, settings.p1type, settings.p2type, current);
+		if (current != nullptr) {
+			writer->write(record);
+		}
+
+		// Determine who won the game.
+		double player2_score = player2.get_playout_score(gameBoard);
+		if (player2_score == 1) {
+			results.wins++;
+		} else if (player2_score == 0) {
+			results.losses++;
+		} else {
+			results.draws++;
+		}
+		results.pieceDifference += gameBoard.num_pieces(player2.ID()) - gameBoard.num_pieces(player1.ID());
+
+		gameBoard.clear_board();
+	}
+}
+
+// For when two CPU players play a large number of games against each other.
+// Spreads the games across a number of worker threads and only prints a summary of all the games at the end.
+void tournament_play(const Game_settings& settings) {
+	auto start = chrono::steady_clock::now();
+	atomic<int> next_game(0);
+	vector<Tournament_results> results(settings.num_workers);
+	unique_ptr<Game_record_writer> writer = open_record_file(settings);
+	vector<thread> workers;
+	for (int i = 0; i < settings.num_workers; i++) {
+		workers.emplace_back(tournament_worker, cref(settings), ref(next_game), ref(results[i]), writer.get());
+	}
+	for (thread& w : workers) {
+		w.join();
+	}
+	if (writer != nullptr) {
+		writer->close();
 	}
+	auto end = chrono::steady_clock::now();
+	double seconds = chrono::duration_cast<chrono::milliseconds>(end - start).count() / 1000.0;
+
+	// Adds up the results from every worker.
+	Tournament_results total;
+	for (const Tournament_results& r : results) {
+		total.wins += r.wins;
+		total.draws += r.draws;
+		total.losses += r.losses;
+		total.pieceDifference += r.pieceDifference;
+	}
+
+	cout << "Played " << settings.max_games << " games on " << settings.num_workers
+		 << (settings.num_workers == 1 ? " thread in " : " threads in ") << seconds << " seconds." << endl;
+	cout << "Player 2 won " << total.wins << " times, tied " << total.draws << " times, and lost " << total.losses << " times, "
+		 << "winning by " << double(total.pieceDifference) / settings.max_games << " pieces on average." << endl;
+	cout << "Random seed: " << settings.seed << endl << endl;
+
+	cout << "Player 1 played using ";
+	print_player_type(settings.p1type);
 
 	cout << "Player 2 played using ";
-	if (p2type == 1) {
-		cout << "random moves." << endl;
-	} else if (p2type == 2) {
-		cout << "greedy heuristic moves." << endl;
-	} else if (p2type == 3) {
-		cout << "pure Monte Carlo tree search." << endl;
-	} else if (p2type == 4) {
-		cout << "heuristic Monte Carlo tree search." << endl;
+	print_player_type(settings.p2type);
+}
+
+// Plays the CPU games the settings ask for, showing every game or only a summary.
+void watch_games(Game_settings settings) {
+	if (settings.seed == 0) {
+		settings.seed = time(NULL);
 	}
+	if (settings.num_workers == 1 && settings.show_games) {
+		CPU_play(settings);
+	} else {
+		tournament_play(settings);
+	}
+}
+
+// Plays a game between the user and a CPU player that makes moves the way settings.p2type says.
+void human_play(const Game_settings& settings) {
+	// Creates the game board, Human player, and Computer player objects.
+	Board gameBoard;
+	setup_board(gameBoard, settings);
+
+	Human_player User;
+	Computer_player CPU;
+	setup_player(CPU, settings);
+	CPU.new_game(settings.seed == 0 ? time(NULL) : settings.seed);
+
+	string userMove;
+	Location computerMove;
+
+	bool gameStillGoing = true;
+	int lostTurns = 0;
+
+	cout << "Starting the game!" << endl;
+
+	gameBoard.println();
+	while (gameStillGoing) {
+		// If the user can make a move...
+		if (gameBoard.move_exists(User.ID())){
+			User.start_turn();
+			cin >> userMove;
+			// Make sure the move is valid (if not, ask for another move)
+			while (!gameBoard.valid_move(userMove, User.ID())){
+				cin >> userMove;
+			}
+			// Makes the user's move.
+			gameBoard.make_move(userMove, User.ID());
+			lostTurns = 0;
+		} else { // If the user cannot make a move...
+			// Skip the user's turn and make note of it.
+			User.skip_turn();
+			lostTurns++;
+		}
+		if (lostTurns == 2) {
+		// If the user and computer cannot make moves consecutively the game is over.
+			gameStillGoing = false;
+			break;
+		}
+		// Print the current game board to aid the user.
+		gameBoard.println();
+
+		// If the computer can make a move...
+		if (gameBoard.move_exists(CPU.ID())) {
+			CPU.start_turn();
+			// Find the computer's move using the method the user specified.
+			computerMove = get_CPU_move(settings.p2type, CPU, gameBoard);
+			lostTurns = 0;
+			// Tell the user the move the computer made.
+			CPU.print_move(computerMove);
+			// Update the game board.
+			gameBoard.make_move(computerMove, CPU.ID());
+		} else { // If the computer cannot make a move...
+			// Skip the computer's turn and make note of it.
+			CPU.skip_turn();
+			lostTurns++;
+		}
+		// Print the updated game board.
+		gameBoard.println();
+		// If the user and computer cannot make moves consecutively the game is over.
+		if (lostTurns == 2) {
+			gameStillGoing = false;
+		}
+	}
+	// Prints the results of the game.
+	cout << "Here is the final board." << endl;
+	gameBoard.println();
+	gameBoard.print_results();
+
+	cout << "Player 2 played using ";
+	print_player_type(settings.p2type);
+
+	cout << "\nThank you for playing!" << endl;
+}
+
+// Prints how to run the program without the prompts.
+void print_usage() {
+	cout << "Usage: ./a5 [--name value]...\n"
+		 << "With no options the program asks for everything it needs. Otherwise it runs with no prompts:\n"
+		 << "  --mode watch|play      watch two CPU players, or play against one (default watch)\n"
+		 << "  --p1 type              how player 1 makes moves, when watching\n"
+		 << "  --p2 type              how player 2 (the CPU, when playing) makes moves\n"
+		 << "                         random, greedy, mcts, mcts-heuristic, alpha-beta, or mcts-weighted (or 1 to 6)\n"
+		 << "  --games n              how many games to play (default 1)\n"
+		 << "How long the CPU players think (the last of these given is used):\n"
+		 << "  --time seconds         stop at 250 playouts per valid move (MCTS), 8 moves deep (alpha-beta), or this time (default 5)\n"
+		 << "  --fixed-time seconds   always think for this long\n"
+		 << "  --playouts n           make n playouts (MCTS) or search n positions (alpha-beta) per move\n"
+		 << "  --nodes n              the same as --playouts\n"
+		 << "  --clock seconds[+inc]  a clock for the whole game, with inc seconds added after every move\n"
+		 << "Other options:\n"
+		 << "  --threads n            how many games to play at once, 1 to 256 (default 1)\n"
+		 << "  --search-threads n     how many threads each CPU player searches with, 1 to 256 (default 1)\n"
+		 << "  --parallel root|tree   whether MCTS threads each grow their own tree or share one (default tree)\n"
+		 << "  --endgame-empties n    solve the game exactly once at most n squares are empty, 0 to 60; 0 turns it off (default 20)\n"
+		 << "  --seed n               seeds the random numbers so the same games can be played again (default: from the time)\n"
+		 << "  --quiet                only print a summary of all the games, not every final board\n"
+		 << "  --record file          records the games in a binary file that ./records can read\n"
+		 << "  --stats                also records how much each move was searched and how long it took\n"
+		 << "  --book file            plays the moves in an opening book built by ./make_book instead of searching\n"
+		 << "  --patterns file        alpha-beta scores positions with the pattern weights in file instead of the positional table\n"
+		 << "  --weights file         uses the positional table and heuristic weights in file, e.g. from ./tune\n"
+		 << "  --config file          reads more options from a file, one \"name = value\" per line; # starts a comment\n"
+		 << "Options are applied in order, so later ones override earlier ones and those in config files." << endl;
+}
+
+// Reads a number from text. Returns false if the text is not entirely a number.
+template<class T>
+bool read_number(const string& text, T& n) {
+	istringstream in(text);
+	return (in >> n) && in.eof();
+}
+
+// Reads a player type from its name or number. Returns 0 if it is not a valid type.
+int read_player_type(const string& text) {
+	const vector<string> names = {"random", "greedy", "mcts", "mcts-heuristic", "alpha-beta", "mcts-weighted"};
+	for (int i = 0; i < names.size(); i++) {
+		if (text == names[i] || text == to_string(i + 1)) {
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+bool read_config(const string& filename, Game_settings& settings);
+
+// Applies one option to the settings.
+// Prints what was wrong and returns false if the option or its value is not valid.
+bool apply_option(const string& name, const string& value, Game_settings& settings) {
+	bool valid = true;
+	if (name == "mode") {
+		valid = (value == "watch" || value == "play");
+		settings.watch = (value == "watch");
+	} else if (name == "p1") {
+		settings.p1type = read_player_type(value);
+		valid = (settings.p1type != 0);
+	} else if (name == "p2") {
+		settings.p2type = read_player_type(value);
+		valid = (settings.p2type != 0);
+	} else if (name == "games") {
+		valid = read_number(value, settings.max_games) && settings.max_games >= 1;
+	} else if (name == "time" || name == "fixed-time") {
+		double seconds;
+		valid = read_number(value, seconds) && seconds > 0;
+		settings.time_control = (name == "time") ? Time_control::standard(seconds) : Time_control::fixed_time(seconds);
+	} else if (name == "playouts" || name == "nodes") {
+		long long count;
+		valid = read_number(value, count) && count > 0;
+		settings.time_control = (name == "playouts") ? Time_control::fixed_playouts(count) : Time_control::fixed_nodes(count);
+	} else if (name == "clock") {
+		// The time for the whole game, optionally followed by + and the increment per move.
+		size_t plus = value.find('+');
+		double seconds;
+		double increment = 0;
+		valid = read_number(value.substr(0, plus), seconds) && seconds > 0
+			&& (plus == string::npos || (read_number(value.substr(plus + 1), increment) && increment >= 0));
+		settings.time_control = Time_control::game_clock(seconds, increment);
+	} else if (name == "threads") {
+		valid = read_number(value, settings.num_workers) && settings.num_workers >= 1 && settings.num_workers <= 256;
+	} else if (name == "search-threads") {
+		valid = read_number(value, settings.search_threads) && settings.search_threads >= 1 && settings.search_threads <= 256;
+	} else if (name == "endgame-empties") {
+		valid = read_number(value, settings.endgame_empties) && settings.endgame_empties >= 0 && settings.endgame_empties <= 60;
+	} else if (name == "parallel") {
+		valid = (value == "root" || value == "tree");
+		settings.parallel_mode = (value == "root") ? Parallel_mode::root : Parallel_mode::tree;
+	} else if (name == "seed") {
+		valid = read_number(value, settings.seed);
+	} else if (name == "quiet") {
+		valid = (value == "true" || value == "false");
+		settings.show_games = (value != "true");
+	} else if (name == "record") {
+		valid = !value.empty();
+		settings.record_file = value;
+	} else if (name == "stats") {
+		valid = (value == "true" || value == "false");
+		settings.record_stats = (value == "true");
+	} else if (name == "book") {
+		valid = !value.empty() && ifstream(value).good();
+		settings.book_file = value;
+	} else if (name == "weights") {
+		valid = !value.empty() && ifstream(value).good();
+		if (valid) {
+			settings.weights = make_shared<const Heuristic_weights>(Heuristic_weights::read(value));
+		}
+	} else if (name == "patterns") {
+		valid = !value.empty() && ifstream(value).good();
+		if (valid) {
+			settings.patterns = make_shared<const Pattern_eval>(value);
+		}
+	} else if (name == "config") {
+		return read_config(value, settings);
+	} else {
+		cout << "Unknown option: " << name << endl;
+		return false;
+	}
+	if (!valid) {
+		cout << "Invalid value for " << name << ": " << value << endl;
+	}
+	return valid;
+}
+
+// Reads options from a file with one "name = value" per line.
+// Blank lines and anything after a # are ignored.
+// A config file can read another with "config = file", but not one that is already being read, which would never end.
+// A relative path in a config file is taken from the directory the config file is in.
+bool read_config(const string& file, Game_settings& settings) {
+	// The full paths of the config files being read, outermost first.
+	static vector<string> open_files;
+	string filename = file;
+	if (!open_files.empty() && !filename.empty() && filename[0] != '/') {
+		const string& including = open_files.back();
+		filename = including.substr(0, including.rfind('/') + 1) + filename;
+	}
+	ifstream in(filename);
+	char* fullPath = realpath(filename.c_str(), nullptr);
+	if (!in || fullPath == nullptr) {
+		free(fullPath);
+		cout << "Can't open config file: " << filename << endl;
+		return false;
+	}
+	string path = fullPath;
+	free(fullPath);
+	if (find(open_files.begin(), open_files.end(), path) != open_files.end()) {
+		cout << "Config file reads itself: " << filename << endl;
+		return false;
+	}
+	open_files.push_back(path);
+
+	bool valid = true;
+	string line;
+	while (valid && getline(in, line)) {
+		line = line.substr(0, line.find('#'));
+		size_t equals = line.find('=');
+		istringstream name(line.substr(0, equals));
+		string n, v;
+		name >> n;
+		if (n.empty()) {
+			continue;
+		}
+		if (equals != string::npos) {
+			istringstream value(line.substr(equals + 1));
+			value >> v;
+		}
+		valid = apply_option(n, v, settings);
+	}
+	open_files.pop_back();
+	return valid;
 }
 
-int main() {
-	srand(time(NULL));
+// Runs the program from command line options instead of prompts, so it can be run unattended.
+// Returns the exit status.
+int run_from_options(int argc, char* argv[]) {
+	Game_settings settings;
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if (arg == "--help" || arg == "-h") {
+			print_usage();
+			return 0;
+		}
+		if (arg.substr(0, 2) != "--") {
+			cout << "Unexpected argument: " << arg << endl;
+			print_usage();
+			return 1;
+		}
+		string name = arg.substr(2);
+		string value;
+		size_t equals = name.find('=');
+		if (equals != string::npos) {
+			value = name.substr(equals + 1);
+			name = name.substr(0, equals);
+		} else if (name == "quiet" || name == "stats") {
+			value = "true";
+		} else if (i + 1 < argc) {
+			value = argv[++i];
+		}
+		if (!apply_option(name, value, settings)) {
+			print_usage();
+			return 1;
+		}
+	}
+
+	if (settings.p2type == 0 || (settings.watch && settings.p1type == 0)) {
+		cout << (settings.watch ? "Both --p1 and --p2 are needed to watch games." : "--p2 is needed to play a game.") << endl;
+		print_usage();
+		return 1;
+	}
+	if (settings.watch) {
+		watch_games(settings);
+	} else {
+		human_play(settings);
+	}
+	return 0;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc > 1) {
+		return run_from_options(argc, argv);
+	}
+
 	int game_type;
+	Game_settings settings;
 
 	// Prints the welcome message.
 	welcome();
@@ -198,42 +719,56 @@ int main() {
 		cout << "Enter 1 for randomly,\n"
 			 << "2 for greedily using a combination of good heuristics,\n"
 			 << "3 for via pure Monte Carlo tree search,\n"
-			 << "and 4 for via Monte Carlo tree search using the good heuristics.\n\n";
+			 << "4 for via Monte Carlo tree search using the good heuristics,\n"
+			 << "5 for via alpha-beta search,\n"
+			 << "and 6 for via Monte Carlo tree search using fast weighted playouts.\n\n";
 
 		cout << "How should the first CPU player make moves?\n" << endl;
-		int p1type;
-		cin >> p1type;
+		cin >> settings.p1type;
 		cout << endl;
-		if (p1type != 1 && p1type != 2 && p1type != 3 && p1type != 4) {
+		if (settings.p1type < 1 || settings.p1type > 6) {
 			cout << "\nYou made an invalid selection. Ending program early.\n";
 			return 0;
 		}
 
-		int p2type;
 		cout << "Enter 1 for randomly,\n"
 			 << "2 for greedily using a combination of good heuristics,\n"
 			 << "3 for via pure Monte Carlo tree search,\n"
-			 << "and 4 for via Monte Carlo tree search using the good heuristics.\n\n";
+			 << "4 for via Monte Carlo tree search using the good heuristics,\n"
+			 << "5 for via alpha-beta search,\n"
+			 << "and 6 for via Monte Carlo tree search using fast weighted playouts.\n\n";
 
 		cout << "How should the second CPU player make moves?\n" << endl;
-		cin >> p2type;
+		cin >> settings.p2type;
 		cout << endl;
-		if (p2type != 1 && p2type != 2 && p2type != 3 && p2type != 4) {
+		if (settings.p2type < 1 || settings.p2type > 6) {
 			cout << "\nYou made an invalid selection. Ending program early.\n";
 			return 0;
 		}
 
-		int max_games;
-		cout << "How many games should they play? Choose between 1 and 10,000 (no commas)." << endl;
-		cin >> max_games;
+		cout << "How many games should they play? Choose 1 or more (no commas)." << endl;
+		cin >> settings.max_games;
 		cout << endl;
-		if (max_games < 1 || max_games > 10000) {
+		if (settings.max_games < 1) {
 			cout << "\nYou made an invalid selection. Ending program early.\n";
 			return 0;
 		}
 
+		cout << "How many threads should play the games at once? Choose between 1 and 256.\n"
+			 << "With 1 thread every final board is shown, otherwise only a summary of all the games is." << endl;
+		cin >> settings.num_workers;
+		cout << endl;
+		if (settings.num_workers < 1 || settings.num_workers > 256) {
+			cout << "\nYou made an invalid selection. Ending program early.\n";
+			return 0;
+		}
+
+		cout << "Enter a random seed to replay earlier games, or 0 to play new ones." << endl;
+		cin >> settings.seed;
+		cout << endl;
+
 		// Play the specified number of games using the two CPU types.
-		CPU_play(p1type, p2type, max_games);
+		watch_games(settings);
 	} else {
 		cout << "So you've decided to try your luck playing against a computer opponent. "
 			 << "I'm going to assume that you already know how to play regular Reversi. "
@@ -241,109 +776,23 @@ int main() {
 			 << "where you would like to play your piece. (i.e. \"g6\")\n\n"
 			 << "You will be \"o\"'s, and you will be going first. Good luck!\n\n\n";
 
-		// Creates the game board, Human player, and Computer player objects.
-		Board gameBoard;
-		gameBoard.set_positional_table(get_positional_table());
-
-		Human_player User;
-		Computer_player CPU;
-
-		string userMove;
-		Location computerMove;
-
-		bool gameStillGoing = true;
-		int lostTurns = 0;
-		int p2type;
 		cout << "Enter 1 for randomly,\n"
 			 << "2 for greedily using a combination of good heuristics,\n"
 			 << "3 for via pure Monte Carlo tree search,\n"
-			 << "and 4 for via Monte Carlo tree search using the good heuristics.\n\n";
+			 << "4 for via Monte Carlo tree search using the good heuristics,\n"
+			 << "5 for via alpha-beta search,\n"
+			 << "and 6 for via Monte Carlo tree search using fast weighted playouts.\n\n";
 
 		cout << "But first, how should the CPU make moves?" << endl;
-		cin >> p2type;
+		cin >> settings.p2type;
 		cout << endl;
-		if (p2type != 1 && p2type != 2 && p2type != 3 && p2type != 4) {
+		if (settings.p2type < 1 || settings.p2type > 6) {
 			cout << "\nYou made an invalid selection. Ending program early.\n";
 			return 0;
 		}
 
-
-		cout << "Starting the game!" << endl;
-
-		gameBoard.println();
-		while (gameStillGoing) {
-			// If the user can make a move...
-			if (gameBoard.move_exists(User.ID())){
-				User.start_turn();
-				cin >> userMove;
-				// Make sure the move is valid (if not, ask for another move)
-				while (!gameBoard.valid_move(userMove, User.ID())){
-					cin >> userMove;
-				}
-				// Makes the user's move.
-				gameBoard.make_move(userMove, User.ID());
-				lostTurns = 0;
-			} else { // If the user cannot make a move...
-				// Skip the user's turn and make note of it.
-				User.skip_turn();
-				lostTurns++;
-			}
-			if (lostTurns == 2) {
-			// If the user and computer cannot make moves consecutively the game is over.
-				gameStillGoing = false;
-				break;
-			}
-			// Print the current game board to aid the user.
-			gameBoard.println();
-
-			// If the computer can make a move...
-			if (gameBoard.move_exists(CPU.ID())) {
-				CPU.start_turn();
-				// Find the computer's move using the method the user specified.
-				if (p2type == 3) {
-					computerMove = CPU.MCTS(gameBoard, "pure");
-				} else if (p2type == 2) {
-					computerMove = gameBoard.get_combined_move(CPU.ID(), User.ID());
-				} else if (p2type == 4) {
-					computerMove = CPU.MCTS(gameBoard, "combined");
-				} else {
-					computerMove = gameBoard.get_random_move(CPU.ID());
-				}
-				lostTurns = 0;
-				// Tell the user the move the computer made.
-				CPU.print_move(computerMove);
-				// Update the game board.
-				gameBoard.make_move(computerMove, CPU.ID());
-			} else { // If the computer cannot make a move...
-				// Skip the computer's turn and make note of it.
-				CPU.skip_turn();
-				lostTurns++;
-			}
-			// Print the updated game board.
-			gameBoard.println();
-			// If the user and computer cannot make moves consecutively the game is over.
-			if (lostTurns == 2) {
-				gameStillGoing = false;
-			}
-		}
-		// Prints the results of the game.
-		cout << "Here is the final board." << endl;
-		gameBoard.println();
-		gameBoard.print_results();
-
-		cout << "Player 2 played using ";
-		if (p2type == 1) {
-			cout << "random moves." << endl;
-		} else if (p2type == 2) {
-			cout << "greedy heuristic moves." << endl;
-		} else if (p2type == 3) {
-			cout << "pure Monte Carlo tree search." << endl;
-		} else if (p2type == 4) {
-			cout << "heuristic Monte Carlo tree search." << endl;
-		}
-
-	cout << "\nThank you for playing!" << endl;
+		human_play(settings);
 	}
 
 	return 0;
-}
\ No newline at end of file
+}
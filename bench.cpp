@@ -0,0 +1,302 @@
+// bench.cpp
+// Times the board operations and searches the computer players spend their time in.
+// Every benchmark runs over the fixed corpus of opening, midgame, and endgame positions in bench_positions.txt,
+// and is repeated until it has run for at least half a second. The average time per operation is reported,
+// plus playouts per second for the playout and MCTS benchmarks. The MCTS/root2 and MCTS/tree2 benchmarks search with
+// two threads in root and tree parallel mode.
+// The random numbers are seeded the same way on every run, so every run does exactly the same work.
+//
+// Usage: ./bench [filter]
+// Only benchmarks whose names contain filter are run, e.g. ./bench MCTS or ./bench /endgame.
+
+#include <iostream>
+using namespace std;
+
+#include <cstdlib>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <type_traits>
+#include <climits>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cmpt_error.h"
+#include "Random.h"
+#include "Board.h"
+#include "Player.h"
+#include "Transposition_table.h"
+#include "Search_tree.h"
+#include "Endgame_solver.h"
+#include "Time_control.h"
+#include "Playout_policy.h"
+#include "Opening_book.h"
+#include "Pattern_eval.h"
+#include "Computer_player.h"
+
+// The version of bench_positions.txt these benchmarks were written for.
+const int corpus_version = 1;
+
+// How long each benchmark runs for at least.
+const double min_seconds = 0.5;
+
+// A position from the corpus and the player to move in it.
+struct Bench_position {
+	Board board;
+	Square turn;
+};
+
+// Results are added to this so the compiler can't skip work whose result is never used.
+volatile long long sink;
+
+// Reads the positions of one phase ("opening", "midgame", or "endgame") from the corpus.
+vector<Bench_position> read_positions(const string& filename, const string& phase) {
+	ifstream in(filename);
+	if (!in) {
+		cmpt::error("can't open " + filename);
+	}
+	vector<Bench_position> positions;
+	int version = 0;
+	string line;
+	while (getline(in, line)) {
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+		istringstream fields(line);
+		string name, squares, turn;
+		fields >> name >> squares;
+		if (name == "version") {
+			version = stoi(squares);
+			continue;
+		}
+		fields >> turn;
+		if (squares.size() != 64 || (turn != "o" && turn != "x")) {
+			cmpt::error("bad position in " + filename + ": " + line);
+		}
+		if (name != phase) {
+			continue;
+		}
+		Bench_position p;
+		for (int i = 0; i < 64; i++) {
+			p.board.set(i / 8, i % 8, Square(squares[i]));
+		}
+		p.turn = Square(turn[0]);
+		positions.push_back(p);
+	}
+	if (version != corpus_version) {
+		cmpt::error(filename + " is version " + to_string(version) + ", expected version " + to_string(corpus_version));
+	}
+	return positions;
+}
+
+// Runs a benchmark and prints its results, if its name matches the filter.
+// batch runs the operation once over the whole corpus and returns how many operations it did.
+// If playouts is given, batch adds the number of playouts it made to it, and playouts per second are printed as well.
+template<class Batch>
+void run(const string& name, const string& filter, Batch batch, long long* playouts = nullptr) {
+	if (name.find(filter) == string::npos) {
+		return;
+	}
+	long long ops = 0;
+	if (playouts != nullptr) {
+		*playouts = 0;
+	}
+	auto start = chrono::steady_clock::now();
+	double seconds = 0;
+	while (seconds < min_seconds) {
+		ops += batch();
+		seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	}
+	cout << left << setw(36) << name << right << fixed << setprecision(1)
+		 << setw(14) << seconds * 1e9 / ops << " ns/op" << setw(12) << ops << " ops";
+	if (playouts != nullptr) {
+		cout << setw(14) << setprecision(0) << *playouts / seconds << " playouts/s";
+	}
+	cout << endl;
+}
+
+// Times single playouts and whole MCTS moves with a playout policy.
+// Playouts and searches are made by whichever player is to move in each position.
+template<class Policy>
+void bench_playouts(vector<Bench_position>& positions, const string& phase, const string& filter,
+		Computer_player& player1, Computer_player& player2, Random& rng) {
+	const string name = Policy::name;
+	long long playouts;
+	run("play_out/" + name + "/" + phase, filter, [&] {
+		double total = 0;
+		for (Bench_position& p : positions) {
+			Computer_player& player = (p.turn == player1.ID()) ? player1 : player2;
+			total += player.play_out<Policy>(p.board, p.turn, rng);
+		}
+		sink = total;
+		playouts += positions.size();
+		return positions.size();
+	}, &playouts);
+
+	// Each operation is a full MCTS move choice, with the endgame solver off so the endgame positions are searched too.
+	// The players start a new game before every search so no tree is reused and each search does the same work.
+	player1.set_endgame_empties(0);
+	player2.set_endgame_empties(0);
+	run("MCTS/" + name + "/" + phase, filter, [&] {
+		long long total = 0;
+		for (int i = 0; i < positions.size(); i++) {
+			Bench_position& p = positions[i];
+			Computer_player& player = (p.turn == player1.ID()) ? player1 : player2;
+			player.new_game(i + 1);
+			Location move = player.MCTS<Policy>(p.board);
+			total += move.row * 8 + move.col;
+			playouts += player.playouts_searched();
+		}
+		sink = total;
+		return positions.size();
+	}, &playouts);
+}
+
+// Times whole MCTS moves with the search split between threads, once for each parallel mode.
+// Each thread makes as many playouts as a single-threaded search would, however the threads share them.
+template<class Policy>
+void bench_parallel(vector<Bench_position>& positions, const string& phase, const string& filter,
+		Computer_player& player1, Computer_player& player2, int threads) {
+	const string name = Policy::name;
+	for (Parallel_mode mode : {Parallel_mode::root, Parallel_mode::tree}) {
+		const string modeName = (mode == Parallel_mode::root) ? "root" : "tree";
+		player1.set_threads(threads, mode);
+		player2.set_threads(threads, mode);
+		long long playouts;
+		run("MCTS/" + modeName + to_string(threads) + "/" + name + "/" + phase, filter, [&] {
+			long long total = 0;
+			for (int i = 0; i < positions.size(); i++) {
+				Bench_position& p = positions[i];
+				Computer_player& player = (p.turn == player1.ID()) ? player1 : player2;
+				player.new_game(i + 1);
+				Location move = player.MCTS<Policy>(p.board);
+				total += move.row * 8 + move.col;
+				playouts += player.playouts_searched();
+			}
+			sink = total;
+			return positions.size();
+		}, &playouts);
+	}
+	player1.set_threads(1, Parallel_mode::tree);
+	player2.set_threads(1, Parallel_mode::tree);
+}
+
+int main(int argc, char* argv[]) {
+	string filter = (argc > 1) ? argv[1] : "";
+	const string filename = "bench_positions.txt";
+
+	cout << "Corpus: " << filename << " version " << corpus_version << endl;
+	cout << left << setw(36) << "Benchmark" << right << setw(20) << "Time" << setw(16) << "Operations" << endl;
+
+	for (const string phase : {"opening", "midgame", "endgame"}) {
+		vector<Bench_position> positions = read_positions(filename, phase);
+		Random rng(1);
+
+		run("get_valid_moves/" + phase, filter, [&] {
+			long long total = 0;
+			for (const Bench_position& p : positions) {
+				total += p.board.get_valid_moves(p.turn).size();
+			}
+			sink = total;
+			return positions.size();
+		});
+
+		run("move_exists/" + phase, filter, [&] {
+			long long total = 0;
+			for (const Bench_position& p : positions) {
+				total += p.board.move_exists(p.turn) + p.board.move_exists(other(p.turn));
+			}
+			sink = total;
+			return positions.size() * 2;
+		});
+
+		// Each operation makes one valid move and takes it back.
+		run("make_move/" + phase, filter, [&] {
+			long long n = 0;
+			long long total = 0;
+			for (Bench_position& p : positions) {
+				for (uint64_t moves = p.board.get_moves(p.turn); moves; moves &= moves - 1) {
+					int sq = __builtin_ctzll(moves);
+					Undo_record record = p.board.make_move(Location{sq / 8, sq % 8}, p.turn);
+					total += record.flips;
+					p.board.undo_move(record);
+					n++;
+				}
+			}
+			sink = total;
+			return n;
+		});
+
+		// Each operation scores one square, valid move or not.
+		run("calc_score/" + phase, filter, [&] {
+			long long total = 0;
+			for (const Bench_position& p : positions) {
+				for (int r = 0; r < 8; r++) {
+					for (int c = 0; c < 8; c++) {
+						total += p.board.calc_score(r, c, p.turn);
+					}
+				}
+			}
+			sink = total;
+			return positions.size() * 64;
+		});
+
+		run("get_positional_board_score/" + phase, filter, [&] {
+			long long total = 0;
+			for (const Bench_position& p : positions) {
+				total += p.board.get_positional_board_score(p.turn, other(p.turn));
+			}
+			sink = total;
+			return positions.size();
+		});
+
+		// Scores each position with patterns that give the same scores as the positional table, for comparison with it.
+		Pattern_eval patterns = Pattern_eval::from_positional_table(standardPositionalTable);
+		vector<Pattern_codes> codes(positions.size());
+		for (int i = 0; i < positions.size(); i++) {
+			codes[i].set(positions[i].board);
+		}
+		run("pattern_evaluate/" + phase, filter, [&] {
+			long long total = 0;
+			for (int i = 0; i < positions.size(); i++) {
+				total += patterns.evaluate(codes[i], positions[i].turn, positions[i].board.num_empty_squares());
+			}
+			sink = total;
+			return positions.size();
+		});
+
+		run("get_combined_move/" + phase, filter, [&] {
+			long long total = 0;
+			for (const Bench_position& p : positions) {
+				Location move = p.board.get_combined_move(p.turn, other(p.turn), rng);
+				total += move.row * 8 + move.col;
+			}
+			sink = total;
+			return positions.size();
+		});
+
+		// Playouts and searches are made by whichever player is to move in each position.
+		Computer_player player1;
+		player1.invert_pieces();
+		Computer_player player2;
+		bench_playouts<Pure_playout>(positions, phase, filter, player1, player2, rng);
+		bench_playouts<Combined_playout>(positions, phase, filter, player1, player2, rng);
+		bench_playouts<Weighted_playout>(positions, phase, filter, player1, player2, rng);
+		bench_parallel<Weighted_playout>(positions, phase, filter, player1, player2, 2);
+	}
+	return 0;
+}
@@ -0,0 +1,94 @@
+// check_combined.cpp
+// Checks that Board::get_combined_move, which scores four moves at a time without making them,
+// picks the same moves as scoring them one at a time by making each move, scoring the board, and taking it back.
+// Takes positions from seeded random games, in every phase so both the early and late game weights are used,
+// and asks both for a move for each player with the random numbers in the same state, so ties are broken the same way.
+// Exits with a non-zero status if any move differs.
+
+#include <iostream>
+using namespace std;
+
+#include <cstdlib>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <type_traits>
+
+#include "cmpt_error.h"
+#include "Random.h"
+#include "Board.h"
+
+// Scores every move by making it on b, scoring the board, and taking it back, with the same heuristics and weights
+// as get_combined_move, then picks one of the best with rng.
+Location reference_combined_move(Board& b, Square s, Square opp, Random& rng) {
+	vector<Location> possibilities = b.get_valid_moves(s);
+	const Combined_weights& weights = standardCombinedWeights;
+	const double* w = (b.num_empty_squares() <= weights.lateEmpties) ? weights.late : weights.early;
+
+	vector<double> all_scores;
+	for (int i = 0; i < possibilities.size(); i++) {
+		Undo_record record = b.make_move(possibilities[i], s);
+		double positional_score = b.get_positional_board_score(s, opp);
+		double opp_moves = __builtin_popcountll(b.get_moves(opp));
+		double flipped = __builtin_popcountll(record.flips) + 1;
+		b.undo_move(record);
+		all_scores.push_back((w[0] * positional_score) + (w[1] * (100 / (opp_moves + 1)))
+			+ (w[2] * (100 / (flipped + 1))) + (w[3] * 100 * flipped));
+	}
+
+	double max_score = *max_element(all_scores.begin(), all_scores.end());
+	vector<int> good_moves;
+	for (int i = 0; i < possibilities.size(); i++) {
+		if (all_scores[i] == max_score) {
+			good_moves.push_back(i);
+		}
+	}
+	return possibilities[good_moves[rng.below(good_moves.size())]];
+}
+
+int main() {
+	Random rng(1);
+	const int num_games = 2000;
+
+	long long checked = 0;
+	long long errors = 0;
+	for (int game = 0; game < num_games; game++) {
+		Board b;
+		Square turn = Square::human;
+		while (b.move_exists(turn) || b.move_exists(other(turn))) {
+			// Asks for a move for both players in every position, so positions where either one has no move are skipped.
+			for (Square s : {turn, other(turn)}) {
+				if (!b.move_exists(s)) {
+					continue;
+				}
+				uint64_t seed = rng.next();
+				Random fast_rng(seed);
+				Random reference_rng(seed);
+				Location fast = b.get_combined_move(s, other(s), fast_rng);
+				Location reference = reference_combined_move(b, s, other(s), reference_rng);
+				checked++;
+				if (fast.row != reference.row || fast.col != reference.col) {
+					errors++;
+					cout << "Mismatch for " << char(s) << ": get_combined_move picked " << char('a' + fast.col) << fast.row + 1
+						 << ", the reference picked " << char('a' + reference.col) << reference.row + 1 << endl;
+					b.print();
+				}
+			}
+			if (b.move_exists(turn)) {
+				b.make_move(b.get_random_move(turn, rng), turn);
+			}
+			turn = other(turn);
+		}
+	}
+
+	cout << "Checked " << checked << " moves from " << num_games << " random games: " << errors << " mismatches." << endl;
+	return errors == 0 ? 0 : 1;
+}
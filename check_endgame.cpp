@@ -0,0 +1,107 @@
+// check_endgame.cpp
+// Checks the endgame solver against a brute force search.
+// Takes positions with 4 to 12 empty squares from seeded random games, and for each one works out the exact result of
+// every move by plain minimax, with no pruning, move ordering, or special cases for the last few squares.
+// The solver must find the same result for the position, and the move it picks must reach that result.
+// Exits with a non-zero status if any position disagrees.
+
+#include <iostream>
+using namespace std;
+
+#include <cstdlib>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <type_traits>
+
+#include "cmpt_error.h"
+#include "Random.h"
+#include "Board.h"
+#include "Endgame_solver.h"
+
+// Returns the final margin for the player to move, p, with both players playing perfectly.
+int minimax(uint64_t p, uint64_t o, bool passed) {
+	uint64_t moves = Board::get_moves(p, o);
+	if (moves == 0) {
+		if (passed) {
+			return __builtin_popcountll(p) - __builtin_popcountll(o);
+		}
+		return -minimax(o, p, true);
+	}
+	int best = -65;
+	for (; moves; moves &= moves - 1) {
+		int sq = __builtin_ctzll(moves);
+		uint64_t flips = Board::get_flips(sq, p, o);
+		best = max(best, -minimax(o & ~flips, p | flips | (1ULL << sq), false));
+	}
+	return best;
+}
+
+// Returns -1, 0, or 1 for a loss, draw, or win by margin.
+int sign(int margin) {
+	return (margin > 0) - (margin < 0);
+}
+
+int main() {
+	Random rng(1);
+	// Each extra empty square makes brute force several times slower, so the last few counts get fewer positions.
+	auto positions_for = [](int empties) {
+		return (empties <= 10) ? 40 : 10;
+	};
+	// The solver gets as long as it needs, so it never gives up.
+	auto deadline = chrono::steady_clock::now() + chrono::hours(24);
+
+	Endgame_solver solver;
+	int checked = 0;
+	int errors = 0;
+	for (int empties = 4; empties <= 12; empties++) {
+		int found = 0;
+		while (found < positions_for(empties)) {
+			// Plays a random game until it has the right number of empty squares with a move to make.
+			Board b;
+			Square turn = Square::human;
+			while (b.num_empty_squares() > empties && (b.move_exists(turn) || b.move_exists(other(turn)))) {
+				if (b.move_exists(turn)) {
+					b.make_move(b.get_random_move(turn, rng), turn);
+				}
+				turn = other(turn);
+			}
+			if (b.num_empty_squares() != empties || !b.move_exists(turn)) {
+				continue;
+			}
+			found++;
+			checked++;
+
+			uint64_t p = b.bits(turn);
+			uint64_t o = b.bits(other(turn));
+			int expected = sign(minimax(p, o, false));
+			Location move{0, 0};
+			int result = -2;
+			bool solved = solver.best_move(b, turn, deadline, move, result);
+			int sq = move.row * 8 + move.col;
+			int reached = -2;
+			if (solved && (Board::get_moves(p, o) >> sq & 1)) {
+				uint64_t flips = Board::get_flips(sq, p, o);
+				reached = -sign(minimax(o & ~flips, p | flips | (1ULL << sq), false));
+			}
+			if (!solved || result != expected || reached != expected) {
+				errors++;
+				cout << "Mismatch with " << empties << " empty squares: brute force result " << expected
+					 << ", solver result " << (solved ? to_string(result) : "none") << " with a move that reaches "
+					 << reached << endl;
+				b.print();
+			}
+		}
+	}
+
+	cout << "Checked " << checked << " positions with 4 to 12 empty squares: " << errors << " mismatches." << endl;
+	return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,84 @@
+// check_table.cpp
+// Checks that MCTS playouts backed up by many threads at once all reach the transposition table.
+// Every thread backs up playouts through the same two positions of a search tree, so they keep updating the same slots
+// at the same time, then the visits and wins stored for each position are checked against what the threads added.
+// Exits with a non-zero status if any playout was lost.
+//
+// Usage: ./check_table [threads]
+
+#include <iostream>
+using namespace std;
+
+#include <cstdlib>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <type_traits>
+
+#include "cmpt_error.h"
+#include "Random.h"
+#include "Board.h"
+#include "Transposition_table.h"
+#include "Search_tree.h"
+
+int main(int argc, char* argv[]) {
+	int num_threads = (argc > 1) ? atoi(argv[1]) : 16;
+	const int playouts_per_thread = 100000;
+	if (num_threads < 1) {
+		cout << "Usage: ./check_table [threads]" << endl;
+		return 1;
+	}
+
+	// A root and one child below it.
+	Board b;
+	Search_tree tree(16);
+	tree.reset(b, Square::human, Square::computer);
+	int root = tree.root();
+	int child = tree.expand(root, b, Square::human, Square::computer);
+	Transposition_table table(10);
+	table.new_search();
+
+	// Each thread backs up wins for player 1 and draws in turn, starting with a win.
+	vector<thread> workers;
+	for (int t = 0; t < num_threads; t++) {
+		workers.emplace_back([&] {
+			for (int i = 0; i < playouts_per_thread; i++) {
+				tree.backpropagate(child, (i % 2 == 0) ? 1 : 0.5, Square::human, &table);
+			}
+		});
+	}
+	for (thread& w : workers) {
+		w.join();
+	}
+
+	// The child was reached by player 1's move, so it gets 2 half points for a win and 1 for a draw. The root gets 0 and 1.
+	long long playouts = (long long)num_threads * playouts_per_thread;
+	long long wins = (long long)num_threads * ((playouts_per_thread + 1) / 2);
+	long long draws = (long long)num_threads * (playouts_per_thread / 2);
+	struct Expected {
+		const char* name;
+		int node;
+		long long halfWins;
+	};
+	int errors = 0;
+	for (Expected e : {Expected{"root", root, draws}, Expected{"child", child, 2 * wins + draws}}) {
+		uint64_t payload = 0;
+		int depth;
+		table.probe(tree[e.node].key, payload, depth);
+		Playout_entry entry = Playout_entry::unpack(payload);
+		cout << "The " << e.name << " has " << entry.visits << " visits and " << entry.halfWins
+			 << " half wins in the table, expected " << playouts << " and " << e.halfWins << "." << endl;
+		if (entry.visits != playouts || entry.halfWins != e.halfWins) {
+			errors++;
+		}
+	}
+	return errors == 0 ? 0 : 1;
+}
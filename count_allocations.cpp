@@ -0,0 +1,98 @@
+// count_allocations.cpp
+// Counts how many heap allocations the MCTS playouts make.
+// Replaces the global operator new with one that keeps a count, then runs a batch of
+// pure playouts from positions taken from random games and reports allocations per playout.
+// Exits with a non-zero status if any playout allocated memory.
+
+#include <iostream>
+using namespace std;
+
+#include <cstdlib>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <type_traits>
+#include <climits>
+#include <new>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fstream>
+
+#include "cmpt_error.h"
+#include "Random.h"
+#include "Board.h"
+#include "Player.h"
+#include "Transposition_table.h"
+#include "Search_tree.h"
+#include "Endgame_solver.h"
+#include "Time_control.h"
+#include "Playout_policy.h"
+#include "Opening_book.h"
+#include "Pattern_eval.h"
+#include "Computer_player.h"
+
+// Number of heap allocations made since the program started.
+atomic<long long> num_allocations(0);
+
+void* operator new(size_t size) {
+	num_allocations++;
+	void* p = malloc(size == 0 ? 1 : size);
+	if (p == nullptr) {
+		throw bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void* p) noexcept {
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+	free(p);
+}
+
+int main() {
+	Random rng(1);
+	int num_positions = 100;
+	int playouts_per_position = 100;
+
+	// Collects positions from the start, middle, and end of random games.
+	vector<Board> positions;
+	Board b;
+	Square turn = Square::human;
+	while (positions.size() < num_positions) {
+		if (b.move_exists(turn)) {
+			b.make_move(b.get_random_move(turn, rng), turn);
+			positions.push_back(b);
+		} else if (!b.move_exists(other(turn))) {
+			b.clear_board();
+		}
+		turn = other(turn);
+	}
+
+	Computer_player player;
+	double total = 0;
+	long long before = num_allocations;
+	for (Board& pos : positions) {
+		for (int i = 0; i < playouts_per_position; i++) {
+			total += player.play_out<Pure_playout>(pos, Square::human, rng);
+		}
+	}
+	long long allocations = num_allocations - before;
+	long long playouts = (long long)num_positions * playouts_per_position;
+
+	cout << "Ran " << playouts << " pure playouts (average score " << total / playouts << ")." << endl;
+	cout << "Heap allocations: " << allocations << " (" << double(allocations) / playouts << " per playout)." << endl;
+	return allocations == 0 ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+// make_book.cpp
+// Builds an opening book from game records written by ./a5 --record.
+// Every game is replayed, and each of the first moves played in it is scored by how the game went for the player who made it.
+// For each position reached, the book keeps the move with the best average score, out of the moves played there in
+// at least a minimum number of games. Positions with no such move are left out.
+//
+// Usage: ./make_book book records... [--plies n] [--min-games n]
+// --plies sets how many moves into each game are used (default 16), and --min-games how many games a move needs (default 4).
+
+#include <iostream>
+using namespace std;
+
+#include <cstdlib>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <type_traits>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cmpt_error.h"
+#include "Random.h"
+#include "Board.h"
+#include "Game_record.h"
+#include "Opening_book.h"
+
+// A move played in a recorded game, and the score the player who made it ended up with.
+struct Book_sample {
+	uint64_t key;
+	uint8_t move;
+	// 2 for a win, 1 for a draw, 0 for a loss.
+	uint8_t halfPoints;
+};
+
+// Replays the first plies moves of a game, adding a sample for each one.
+// Returns false if the game has an invalid move.
+bool add_samples(const Game_view& game, int plies, vector<Book_sample>& samples) {
+	Board b;
+	Square turn = Square::human;
+	for (int i = 0; i < game.numMoves && i < plies; i++) {
+		uint8_t sq = game.moves[i];
+		if (sq != Game_record::passMove) {
+			if (sq > 63 || !(b.get_moves(turn) >> sq & 1)) {
+				return false;
+			}
+			int mine = (turn == Square::human) ? game.p1Pieces : game.p2Pieces;
+			int theirs = (turn == Square::human) ? game.p2Pieces : game.p1Pieces;
+			uint8_t halfPoints = (mine > theirs) ? 2 : (mine == theirs) ? 1 : 0;
+			// Positions that are the same up to symmetry are counted together, in their canonical form.
+			int t;
+			uint64_t key = b.canonical_key(turn, t);
+			samples.push_back(Book_sample{key, uint8_t(Board::transform_square(sq, t)), halfPoints});
+			b.make_move(Location{sq / 8, sq % 8}, turn);
+		}
+		turn = other(turn);
+	}
+	return true;
+}
+
+// Turns the samples into book entries, one per position, sorted by key.
+vector<Book_entry> choose_moves(vector<Book_sample>& samples, int min_games) {
+	sort(samples.begin(), samples.end(), [](const Book_sample& a, const Book_sample& b) {
+		return (a.key != b.key) ? a.key < b.key : a.move < b.move;
+	});
+	vector<Book_entry> entries;
+	size_t i = 0;
+	while (i < samples.size()) {
+		uint64_t key = samples[i].key;
+		Book_entry best{key, 0, 0, 0, 0};
+		double bestScore = -1;
+		// Goes through each move played from the position.
+		while (i < samples.size() && samples[i].key == key) {
+			uint8_t move = samples[i].move;
+			long long games = 0;
+			long long halfPoints = 0;
+			for (; i < samples.size() && samples[i].key == key && samples[i].move == move; i++) {
+				games++;
+				halfPoints += samples[i].halfPoints;
+			}
+			double score = halfPoints / (2.0 * games);
+			if (games >= min_games && (score > bestScore || (score == bestScore && games > best.games))) {
+				bestScore = score;
+				best.games = min(games, (long long)UINT32_MAX);
+				best.score = lround(score * 10000);
+				best.move = move;
+			}
+		}
+		if (bestScore >= 0) {
+			entries.push_back(best);
+		}
+	}
+	return entries;
+}
+
+// Writes the entries to a book file.
+void write_book(const string& filename, const vector<Book_entry>& entries) {
+	FILE* file = fopen(filename.c_str(), "wb");
+	if (file == nullptr) {
+		cmpt::error("can't create " + filename);
+	}
+	uint8_t header[bookHeaderSize] = {};
+	memcpy(header, bookMagic, 4);
+	header[4] = bookVersion;
+	uint64_t numEntries = entries.size();
+	memcpy(header + 8, &numEntries, sizeof(numEntries));
+	bool ok = fwrite(header, 1, bookHeaderSize, file) == bookHeaderSize
+		&& fwrite(entries.data(), sizeof(Book_entry), entries.size(), file) == entries.size();
+	if (fclose(file) != 0 || !ok) {
+		cmpt::error("can't write " + filename);
+	}
+}
+
+int main(int argc, char* argv[]) {
+	int plies = 16;
+	int min_games = 4;
+	vector<string> files;
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if ((arg == "--plies" || arg == "--min-games") && i + 1 < argc) {
+			(arg == "--plies" ? plies : min_games) = atoi(argv[++i]);
+		} else {
+			files.push_back(arg);
+		}
+	}
+	if (files.size() < 2 || plies < 1 || min_games < 1) {
+		cout << "Usage: ./make_book book records... [--plies n] [--min-games n]" << endl;
+		return 1;
+	}
+
+	vector<Book_sample> samples;
+	long long num_games = 0;
+	long long bad_games = 0;
+	for (int f = 1; f < files.size(); f++) {
+		Game_record_reader reader(files[f]);
+		Game_view game;
+		while (reader.next(game)) {
+			num_games++;
+			if (!add_samples(game, plies, samples)) {
+				bad_games++;
+			}
+		}
+	}
+	vector<Book_entry> entries = choose_moves(samples, min_games);
+	write_book(files[0], entries);
+
+	cout << "Wrote " << entries.size() << " positions to " << files[0] << " from the first " << plies << " moves of "
+		 << num_games << " games";
+	if (bad_games > 0) {
+		cout << " (" << bad_games << " of them had an invalid move and were only used up to it)";
+	}
+	cout << "." << endl;
+	return 0;
+}
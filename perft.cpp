@@ -0,0 +1,150 @@
+// perft.cpp
+// Counts every sequence of moves from a position to a given depth (perft), to check move generation and measure its speed.
+// A pass counts as a move when the player to move has none but the opponent does, just like a lost turn in a game.
+// A game that ends before the depth is reached counts as one sequence.
+// Moves are made and taken back with Board::make_move and Board::undo_move, so the whole move making path is checked.
+// At the last move the moves are only counted, not made, and the moves from the position are split between threads.
+//
+// Usage: ./perft depth [threads] [squares turn]
+// Counts depths 1 to depth. The position defaults to the start of the game and is given as the 64 squares row by row
+// from a1 to h8 (. empty, o player 1, x player 2) and the player to move (o or x), e.g. as in bench_positions.txt.
+// From the start position the counts are checked against the known ones, and the program exits with an error if any differ.
+
+#include <iostream>
+using namespace std;
+
+#include <cstdlib>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <type_traits>
+#include <iomanip>
+
+#include "cmpt_error.h"
+#include "Random.h"
+#include "Board.h"
+
+// The known counts from the start position, for depths 1 to 14.
+const long long known_counts[] = {
+	4, 12, 56, 244, 1396, 8200, 55092, 390216, 3005288, 24571284,
+	212258800, 1939886636, 18429641748, 184042084512
+};
+const int num_known_counts = sizeof(known_counts) / sizeof(known_counts[0]);
+
+// Counts the move sequences of the given length from position b with turn to move.
+// passed is true if the last move was a pass.
+long long perft(Board& b, Square turn, int depth, bool passed) {
+	uint64_t moves = b.get_moves(turn);
+	if (moves == 0) {
+		// Two passes in a row end the game.
+		if (passed) {
+			return 1;
+		}
+		return (depth == 1) ? 1 : perft(b, other(turn), depth - 1, true);
+	}
+	// Bulk counting: the moves at the last level only need counting.
+	if (depth == 1) {
+		return __builtin_popcountll(moves);
+	}
+	long long count = 0;
+	for (; moves; moves &= moves - 1) {
+		int sq = __builtin_ctzll(moves);
+		Undo_record record = b.make_move(Location{sq / 8, sq % 8}, turn);
+		count += perft(b, other(turn), depth - 1, false);
+		b.undo_move(record);
+	}
+	return count;
+}
+
+// Same as perft, but the moves from b are shared out between threads, each searching with its own copy of the board.
+long long parallel_perft(const Board& b, Square turn, int depth, int num_threads) {
+	uint64_t moves = b.get_moves(turn);
+	if (depth == 1 || moves == 0 || num_threads == 1) {
+		Board copy = b;
+		return perft(copy, turn, depth, false);
+	}
+	vector<int> squares;
+	for (; moves; moves &= moves - 1) {
+		squares.push_back(__builtin_ctzll(moves));
+	}
+
+	atomic<int> next(0);
+	atomic<long long> total(0);
+	vector<thread> workers;
+	for (int i = 0; i < num_threads; i++) {
+		workers.emplace_back([&] {
+			int m;
+			while ((m = next.fetch_add(1)) < squares.size()) {
+				Board copy = b;
+				copy.make_move(Location{squares[m] / 8, squares[m] % 8}, turn);
+				total += perft(copy, other(turn), depth - 1, false);
+			}
+		});
+	}
+	for (thread& w : workers) {
+		w.join();
+	}
+	return total;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc != 2 && argc != 3 && argc != 5) {
+		cout << "Usage: ./perft depth [threads] [squares turn]" << endl;
+		return 1;
+	}
+	int max_depth = atoi(argv[1]);
+	int num_threads = (argc > 2) ? atoi(argv[2]) : max(int(thread::hardware_concurrency()), 1);
+	if (max_depth < 1 || num_threads < 1) {
+		cout << "The depth and number of threads must be at least 1." << endl;
+		return 1;
+	}
+
+	Board b;
+	Square turn = Square::human;
+	bool start_position = (argc != 5);
+	if (!start_position) {
+		string squares = argv[3];
+		string player = argv[4];
+		if (squares.size() != 64 || (player != "o" && player != "x")) {
+			cout << "The position must be 64 squares of ., o, or x, followed by o or x for the player to move." << endl;
+			return 1;
+		}
+		for (int i = 0; i < 64; i++) {
+			if (squares[i] != '.' && squares[i] != 'o' && squares[i] != 'x') {
+				cout << "The position must be 64 squares of ., o, or x, followed by o or x for the player to move." << endl;
+				return 1;
+			}
+			b.set(i / 8, i % 8, Square(squares[i]));
+		}
+		turn = Square(player[0]);
+	}
+
+	cout << "Perft on " << num_threads << (num_threads == 1 ? " thread" : " threads") << endl;
+	cout << setw(5) << "Depth" << setw(16) << "Sequences" << setw(12) << "Seconds" << setw(16) << "Moves/s" << endl;
+	bool all_match = true;
+	for (int depth = 1; depth <= max_depth; depth++) {
+		auto start = chrono::steady_clock::now();
+		long long count = parallel_perft(b, turn, depth, num_threads);
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		cout << setw(5) << depth << setw(16) << count << fixed << setprecision(3) << setw(12) << seconds
+			 << setprecision(0) << setw(16) << count / max(seconds, 1e-9);
+		if (start_position && depth <= num_known_counts) {
+			if (count == known_counts[depth - 1]) {
+				cout << "  ok";
+			} else {
+				cout << "  expected " << known_counts[depth - 1];
+				all_match = false;
+			}
+		}
+		cout << endl;
+	}
+	return all_match ? 0 : 1;
+}
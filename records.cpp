@@ -0,0 +1,164 @@
+// records.cpp
+// Reads a game record file written by ./a5 --record, replays every game to check it, and summarizes the games.
+// Each game's moves are made on a board, so an illegal move, a missing pass, or a final score that doesn't match
+// the one recorded means the file is damaged.
+//
+// Usage: ./records file [game]
+// With a game number, also prints that game's moves (and search statistics, if it has them).
+
+#include <iostream>
+using namespace std;
+
+#include <cstdlib>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <type_traits>
+#include <iomanip>
+#include <map>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cmpt_error.h"
+#include "Random.h"
+#include "Board.h"
+#include "Game_record.h"
+
+// Returns a square's name, e.g. d3, or pass.
+string square_name(uint8_t sq) {
+	if (sq == Game_record::passMove) {
+		return "pass";
+	}
+	return string(1, char('a' + sq % 8)) + char('1' + sq / 8);
+}
+
+// Replays a game, returning an empty string if it is valid or what is wrong with it.
+// Player 1 is Square::human and moves first.
+string check_game(const Game_view& game) {
+	Board b;
+	Square turn = Square::human;
+	for (int i = 0; i < game.numMoves; i++) {
+		uint64_t moves = b.get_moves(turn);
+		uint8_t sq = game.moves[i];
+		if (sq == Game_record::passMove) {
+			if (moves != 0) {
+				return "move " + to_string(i + 1) + " passes when there are moves";
+			}
+		} else if (sq > 63 || !(moves >> sq & 1)) {
+			return "move " + to_string(i + 1) + " (" + to_string(sq) + ") is not a valid move";
+		} else {
+			b.make_move(Location{sq / 8, sq % 8}, turn);
+		}
+		turn = other(turn);
+	}
+	if (b.move_exists(Square::human) || b.move_exists(Square::computer)) {
+		return "the game isn't over";
+	}
+	if (b.num_pieces(Square::human) != game.p1Pieces || b.num_pieces(Square::computer) != game.p2Pieces) {
+		return "the recorded score doesn't match the final board";
+	}
+	return "";
+}
+
+// Prints a game's moves, one per line.
+void print_game(const Game_view& game) {
+	cout << "Game " << game.game << " of the match with seed " << game.seed << ": player types " << int(game.p1type)
+		 << " and " << int(game.p2type) << ", final score " << int(game.p1Pieces) << "-" << int(game.p2Pieces) << endl;
+	for (int i = 0; i < game.numMoves; i++) {
+		cout << setw(3) << i + 1 << ". " << ((i % 2 == 0) ? "player 1 " : "player 2 ") << setw(4) << square_name(game.moves[i]);
+		if (game.stats != nullptr) {
+			Move_stats s = game.get_stats(i);
+			cout << setw(12) << s.count << " searched" << setw(12) << s.microseconds << " us";
+		}
+		cout << endl;
+	}
+}
+
+// The totals for every game between the same two player types.
+struct Matchup {
+	long long games = 0;
+	long long p1Wins = 0;
+	long long draws = 0;
+	long long p2Wins = 0;
+	long long moves = 0;
+	// The totals for the moves with statistics, by player.
+	long long statsMoves[2] = {0, 0};
+	long long searched[2] = {0, 0};
+	long long microseconds[2] = {0, 0};
+};
+
+int main(int argc, char* argv[]) {
+	if (argc != 2 && argc != 3) {
+		cout << "Usage: ./records file [game]" << endl;
+		return 1;
+	}
+	long long show = (argc == 3) ? atoll(argv[2]) : -1;
+
+	auto start = chrono::steady_clock::now();
+	Game_record_reader reader(argv[1]);
+	map<pair<int, int>, Matchup> matchups;
+	long long num_games = 0;
+	long long bad_games = 0;
+	Game_view game;
+	while (reader.next(game)) {
+		string problem = check_game(game);
+		if (!problem.empty()) {
+			if (bad_games < 10) {
+				cout << "Game " << num_games << " (game " << game.game << " of seed " << game.seed << "): " << problem << endl;
+			}
+			bad_games++;
+		}
+		if (game.game == show) {
+			print_game(game);
+		}
+
+		Matchup& m = matchups[{game.p1type, game.p2type}];
+		m.games++;
+		m.moves += game.numMoves;
+		if (game.p1Pieces > game.p2Pieces) {
+			m.p1Wins++;
+		} else if (game.p1Pieces < game.p2Pieces) {
+			m.p2Wins++;
+		} else {
+			m.draws++;
+		}
+		if (game.stats != nullptr) {
+			for (int i = 0; i < game.numMoves; i++) {
+				if (game.moves[i] != Game_record::passMove) {
+					Move_stats s = game.get_stats(i);
+					m.statsMoves[i % 2]++;
+					m.searched[i % 2] += s.count;
+					m.microseconds[i % 2] += s.microseconds;
+				}
+			}
+		}
+		num_games++;
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	cout << "Read and replayed " << num_games << " games in " << fixed << setprecision(3) << seconds << " seconds";
+	cout << ((bad_games == 0) ? ", all valid." : ", " + to_string(bad_games) + " invalid.") << endl;
+	for (const auto& [types, m] : matchups) {
+		cout << "Player types " << types.first << " vs " << types.second << ": " << m.games << " games, player 1 won "
+			 << m.p1Wins << ", tied " << m.draws << ", lost " << m.p2Wins << ", "
+			 << setprecision(1) << double(m.moves) / m.games << " moves per game" << endl;
+		for (int p = 0; p < 2; p++) {
+			if (m.statsMoves[p] > 0) {
+				cout << "  Player " << p + 1 << " searched " << setprecision(0) << double(m.searched[p]) / m.statsMoves[p]
+					 << " per move in " << setprecision(2) << m.microseconds[p] / 1000.0 / m.statsMoves[p] << " ms on average" << endl;
+			}
+		}
+	}
+	return (bad_games == 0) ? 0 : 1;
+}
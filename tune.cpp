@@ -0,0 +1,692 @@
+// tune.cpp
+// Fits the evaluation weights to recorded games, instead of choosing them by trial and error.
+// Every position in the games is labeled with how the game ended for the player to move: their pieces minus the opponent's.
+//  - The positional table is fit by least squares, so a position's positional score predicts that margin, in tenths of a piece.
+//    Squares that are the same up to symmetry get the same value.
+//  - The combined heuristic's weights (see Board::get_combined_move) are fit by multinomial logistic regression, so the
+//    heuristic picks the moves the searching players (MCTS and alpha-beta) picked as often as it can.
+//    The early and late game weights are fit separately, with Newton's method, using the fitted table's positional scores.
+//    The table and weights only work as a pair, so if the standard table and weights pick the searching players' moves
+//    more often on the held back games, the standard pair is written instead.
+//  - The pattern weights (see Pattern_eval.h) are fit by gradient descent, so the pattern evaluation predicts the margin.
+//    They start out giving the same scores as the fitted positional table, and the weights from the step that did best
+//    on the held back games are kept.
+// Every tenth game is held back and only used to check how well the weights do on games they weren't fit to.
+// The work on the positions is split between threads.
+//
+// Usage: ./tune [--weights file] [--patterns file] [--threads n] [--iterations n] inputs...
+// The inputs are game record files from ./a5 --record, or text files of labeled positions, one per line:
+// the 64 squares row by row from a1 to h8 (. empty, o player 1, x player 2), the player to move (o or x),
+// and the player to move's final margin. Labeled positions are only used for the positional table and patterns.
+// --weights writes the positional table and combined weights for ./a5 --weights, and --patterns the pattern weights for
+// ./a5 --patterns. --iterations sets how many steps of gradient descent fit the patterns (default 50).
+
+#include <iostream>
+using namespace std;
+
+#include <cstdlib>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <type_traits>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cmpt_error.h"
+#include "Random.h"
+#include "Board.h"
+#include "Game_record.h"
+#include "Pattern_eval.h"
+#include "Heuristic_weights.h"
+
+// A position to learn from.
+struct Sample {
+	// The player to move's pieces and the opponent's.
+	uint64_t p;
+	uint64_t o;
+	// The player to move's pieces minus the opponent's at the end of the game.
+	int margin;
+	// The square the player to move played, or -1 if it isn't known or wasn't played by a searching player.
+	int move;
+	// Whether the sample is held back to check the weights with.
+	bool test;
+};
+
+// Adds the positions from a game record file.
+void read_records(const string& filename, vector<Sample>& samples) {
+	Game_record_reader reader(filename);
+	Game_view game;
+	long long num_games = 0;
+	while (reader.next(game)) {
+		bool test = (num_games++ % 10 == 9);
+		Board b;
+		Square turn = Square::human;
+		for (int i = 0; i < game.numMoves; i++) {
+			uint8_t sq = game.moves[i];
+			if (sq != Game_record::passMove) {
+				if (sq > 63 || !(b.get_moves(turn) >> sq & 1)) {
+					cmpt::error("game " + to_string(game.game) + " in " + filename + " has an invalid move");
+				}
+				int margin = game.p1Pieces - game.p2Pieces;
+				uint8_t type = (turn == Square::human) ? game.p1type : game.p2type;
+				// Random and greedy moves aren't worth copying.
+				int move = (type == 1 || type == 2) ? -1 : sq;
+				samples.push_back(Sample{b.bits(turn), b.bits(other(turn)), (turn == Square::human) ? margin : -margin, move, test});
+				b.make_move(Location{sq / 8, sq % 8}, turn);
+			}
+			turn = other(turn);
+		}
+	}
+}
+
+// Adds the positions from a file of labeled positions.
+void read_positions(const string& filename, vector<Sample>& samples) {
+	ifstream in(filename);
+	if (!in) {
+		cmpt::error("can't open " + filename);
+	}
+	string line;
+	long long n = 0;
+	while (getline(in, line)) {
+		line = line.substr(0, line.find('#'));
+		istringstream fields(line);
+		string squares, turn;
+		int margin;
+		if (!(fields >> squares)) {
+			continue;
+		}
+		if (!(fields >> turn >> margin) || squares.size() != 64 || (turn != "o" && turn != "x")) {
+			cmpt::error("bad position in " + filename + ": " + line);
+		}
+		Sample s{0, 0, margin, -1, n++ % 10 == 9};
+		for (int i = 0; i < 64; i++) {
+			if (squares[i] == turn[0]) {
+				s.p |= 1ULL << i;
+			} else if (squares[i] != '.') {
+				s.o |= 1ULL << i;
+			}
+		}
+		samples.push_back(s);
+	}
+}
+
+// Splits n items between threads, calling work(thread, begin, end) with each thread's share, and waits for them all.
+template<class Work>
+void parallel_for(int num_threads, size_t n, Work work) {
+	vector<thread> workers;
+	for (int t = 0; t < num_threads; t++) {
+		workers.emplace_back(work, t, n * t / num_threads, n * (t + 1) / num_threads);
+	}
+	for (thread& w : workers) {
+		w.join();
+	}
+}
+
+// Solves a x = b for x by Gaussian elimination. a is n by n, stored row by row.
+vector<double> solve(vector<double> a, vector<double> b) {
+	int n = b.size();
+	for (int col = 0; col < n; col++) {
+		int pivot = col;
+		for (int r = col + 1; r < n; r++) {
+			if (fabs(a[r * n + col]) > fabs(a[pivot * n + col])) {
+				pivot = r;
+			}
+		}
+		for (int c = 0; c < n; c++) {
+			swap(a[col * n + c], a[pivot * n + c]);
+		}
+		swap(b[col], b[pivot]);
+		for (int r = col + 1; r < n; r++) {
+			double f = a[r * n + col] / a[col * n + col];
+			for (int c = col; c < n; c++) {
+				a[r * n + c] -= f * a[col * n + c];
+			}
+			b[r] -= f * b[col];
+		}
+	}
+	vector<double> x(n);
+	for (int r = n - 1; r >= 0; r--) {
+		double sum = b[r];
+		for (int c = r + 1; c < n; c++) {
+			sum -= a[r * n + c] * x[c];
+		}
+		x[r] = sum / a[r * n + r];
+	}
+	return x;
+}
+
+// Fits the positional table by least squares, in tenths of a piece.
+// Each square's feature is 1 if the player to move has it, -1 if the opponent does, and 0 if it is empty,
+// and squares that are the same up to symmetry share one value.
+Positional_table fit_table(const vector<Sample>& samples, int num_threads) {
+	// Numbers the squares' symmetry classes by the first square of each class.
+	int square_class[64];
+	int num_classes = 0;
+	int first_of[64];
+	for (int sq = 0; sq < 64; sq++) {
+		int lowest = sq;
+		for (int t = 0; t < 8; t++) {
+			lowest = min(lowest, Board::transform_square(sq, t));
+		}
+		if (lowest == sq) {
+			first_of[num_classes] = sq;
+			square_class[sq] = num_classes++;
+		} else {
+			square_class[sq] = square_class[lowest];
+		}
+	}
+
+	// Each thread adds up its own share of the normal equations.
+	int n = num_classes;
+	vector<vector<double>> xtx(num_threads, vector<double>(n * n));
+	vector<vector<double>> xty(num_threads, vector<double>(n));
+	parallel_for(num_threads, samples.size(), [&](int t, size_t begin, size_t end) {
+		vector<double> x(n);
+		for (size_t i = begin; i < end; i++) {
+			const Sample& s = samples[i];
+			if (s.test) {
+				continue;
+			}
+			fill(x.begin(), x.end(), 0);
+			for (uint64_t b = s.p; b; b &= b - 1) {
+				x[square_class[__builtin_ctzll(b)]] += 1;
+			}
+			for (uint64_t b = s.o; b; b &= b - 1) {
+				x[square_class[__builtin_ctzll(b)]] -= 1;
+			}
+			for (int j = 0; j < n; j++) {
+				for (int k = 0; k < n; k++) {
+					xtx[t][j * n + k] += x[j] * x[k];
+				}
+				xty[t][j] += x[j] * s.margin * 10;
+			}
+		}
+	});
+	vector<double> a(n * n);
+	vector<double> b(n);
+	for (int t = 0; t < num_threads; t++) {
+		for (int j = 0; j < n * n; j++) {
+			a[j] += xtx[t][j];
+		}
+		for (int j = 0; j < n; j++) {
+			b[j] += xty[t][j];
+		}
+	}
+	// A little ridge regularization, so a square that is never or always filled doesn't make the equations unsolvable.
+	for (int j = 0; j < n; j++) {
+		a[j * n + j] += 1;
+	}
+	vector<double> value = solve(a, b);
+
+	Positional_table table;
+	for (int sq = 0; sq < 64; sq++) {
+		table.weights[sq] = lround(value[square_class[sq]]);
+	}
+	cout << "Fit the positional table (" << num_classes << " values, e.g. corner " << table.weights[first_of[0]] << ")." << endl;
+	return table;
+}
+
+// Returns the root mean square error of a score, in pieces, over the training or test samples.
+template<class Score>
+double rms_error(const vector<Sample>& samples, bool test, Score score) {
+	double sum = 0;
+	long long n = 0;
+	for (size_t i = 0; i < samples.size(); i++) {
+		if (samples[i].test == test) {
+			double err = score(i) / 10.0 - samples[i].margin;
+			sum += err * err;
+			n++;
+		}
+	}
+	return (n > 0) ? sqrt(sum / n) : 0;
+}
+
+// Returns the positional score of a sample with a table.
+int table_score(const Sample& s, const Positional_table& table) {
+	int score = 0;
+	for (uint64_t b = s.p; b; b &= b - 1) {
+		score += table.weights[__builtin_ctzll(b)];
+	}
+	for (uint64_t b = s.o; b; b &= b - 1) {
+		score -= table.weights[__builtin_ctzll(b)];
+	}
+	return score;
+}
+
+// The heuristics get_combined_move weighs for every valid move in the positions a move was learned from.
+struct Move_choices {
+	// Which sample each position came from.
+	vector<int> sample;
+	// Where each position's moves start in features, and which of them was played.
+	vector<int> start;
+	vector<int> played;
+	// Four features per move, in the order of Combined_weights.
+	vector<double> features;
+};
+
+// Works out the heuristics for every valid move in the positions where a searching player's move is known,
+// the same way get_combined_move does, keeping only the early or late game positions.
+Move_choices move_choices(const vector<Sample>& samples, const Positional_table& table, int late_empties, bool late) {
+	Move_choices c;
+	for (int i = 0; i < samples.size(); i++) {
+		const Sample& s = samples[i];
+		int empties = 64 - __builtin_popcountll(s.p | s.o);
+		if (s.move < 0 || (empties <= late_empties) != late) {
+			continue;
+		}
+		c.sample.push_back(i);
+		c.start.push_back(c.features.size() / 4);
+		int current = table_score(s, table);
+		int index = 0;
+		for (uint64_t moves = Board::get_moves(s.p, s.o); moves; moves &= moves - 1, index++) {
+			int sq = __builtin_ctzll(moves);
+			uint64_t flips = Board::get_flips(sq, s.p, s.o);
+			int flipped_worth = 0;
+			for (uint64_t f = flips; f; f &= f - 1) {
+				flipped_worth += table.weights[__builtin_ctzll(f)];
+			}
+			double positional_score = current + table.weights[sq] + 2 * flipped_worth;
+			double opp_moves = __builtin_popcountll(Board::get_moves<uint64_t>(s.o & ~flips, s.p | flips | (1ULL << sq)));
+			double flipped = __builtin_popcountll(flips) + 1;
+			c.features.insert(c.features.end(), {positional_score, 100 / (opp_moves + 1), 100 / (flipped + 1), 100 * flipped});
+			if (sq == s.move) {
+				c.played.push_back(index);
+			}
+		}
+	}
+	c.start.push_back(c.features.size() / 4);
+	return c;
+}
+
+// Returns the fraction of the training or test positions where weights w score the move that was played highest.
+// Ties count as a fraction, as get_combined_move breaks them at random.
+double agreement(const Move_choices& c, const vector<Sample>& samples, bool test, const double* w) {
+	double agree = 0;
+	long long n = 0;
+	for (int i = 0; i + 1 < c.start.size(); i++) {
+		if (samples[c.sample[i]].test != test) {
+			continue;
+		}
+		n++;
+		double best = -1e300;
+		int num_best = 0;
+		bool played_best = false;
+		for (int m = c.start[i]; m < c.start[i + 1]; m++) {
+			const double* x = &c.features[m * 4];
+			double score = w[0] * x[0] + w[1] * x[1] + w[2] * x[2] + w[3] * x[3];
+			if (score > best) {
+				best = score;
+				num_best = 0;
+				played_best = false;
+			}
+			if (score == best) {
+				num_best++;
+				played_best = played_best || (m - c.start[i] == c.played[i]);
+			}
+		}
+		agree += played_best ? 1.0 / num_best : 0;
+	}
+	return (n > 0) ? agree / n : 0;
+}
+
+// Fits one set of combined heuristic weights by multinomial logistic regression with Newton's method:
+// each move's chance of being played is taken to grow exponentially with its weighted score.
+// The features are scaled to the same size first so the steps are well behaved.
+// Returns false and leaves w alone if there are no positions to learn from.
+bool fit_combined(const Move_choices& c, const vector<Sample>& samples, int num_threads, double* w) {
+	int num_positions = c.start.size() - 1;
+	if (num_positions == 0) {
+		return false;
+	}
+	double scale[4];
+	for (int k = 0; k < 4; k++) {
+		double sum = 0;
+		for (int m = 0; m < c.features.size() / 4; m++) {
+			sum += c.features[m * 4 + k] * c.features[m * 4 + k];
+		}
+		scale[k] = max(sqrt(sum / (c.features.size() / 4)), 1e-9);
+	}
+
+	// Adds up the log likelihood, its gradient, and its Hessian for weights beta on the scaled features.
+	struct Totals {
+		double logLikelihood = 0;
+		double gradient[4] = {};
+		double hessian[16] = {};
+	};
+	auto totals = [&](const double* beta) {
+		vector<Totals> parts(num_threads);
+		parallel_for(num_threads, num_positions, [&](int t, size_t begin, size_t end) {
+			Totals& part = parts[t];
+			vector<double> prob;
+			for (size_t i = begin; i < end; i++) {
+				if (samples[c.sample[i]].test) {
+					continue;
+				}
+				int first = c.start[i];
+				int count = c.start[i + 1] - first;
+				prob.assign(count, 0);
+				double top = -1e300;
+				for (int m = 0; m < count; m++) {
+					const double* x = &c.features[(first + m) * 4];
+					for (int k = 0; k < 4; k++) {
+						prob[m] += beta[k] * x[k] / scale[k];
+					}
+					top = max(top, prob[m]);
+				}
+				double total = 0;
+				for (int m = 0; m < count; m++) {
+					prob[m] = exp(prob[m] - top);
+					total += prob[m];
+				}
+				double mean[4] = {};
+				for (int m = 0; m < count; m++) {
+					prob[m] /= total;
+					const double* x = &c.features[(first + m) * 4];
+					for (int k = 0; k < 4; k++) {
+						mean[k] += prob[m] * x[k] / scale[k];
+					}
+				}
+				const double* played = &c.features[(first + c.played[i]) * 4];
+				part.logLikelihood += log(max(prob[c.played[i]], 1e-300));
+				for (int k = 0; k < 4; k++) {
+					part.gradient[k] += played[k] / scale[k] - mean[k];
+				}
+				for (int m = 0; m < count; m++) {
+					const double* x = &c.features[(first + m) * 4];
+					for (int j = 0; j < 4; j++) {
+						for (int k = 0; k < 4; k++) {
+							part.hessian[j * 4 + k] += prob[m] * (x[j] / scale[j] - mean[j]) * (x[k] / scale[k] - mean[k]);
+						}
+					}
+				}
+			}
+		});
+		Totals sum;
+		for (const Totals& part : parts) {
+			sum.logLikelihood += part.logLikelihood;
+			for (int k = 0; k < 4; k++) {
+				sum.gradient[k] += part.gradient[k];
+			}
+			for (int k = 0; k < 16; k++) {
+				sum.hessian[k] += part.hessian[k];
+			}
+		}
+		// A little ridge regularization keeps the weights finite when a feature never matters.
+		for (int k = 0; k < 4; k++) {
+			sum.logLikelihood -= 0.5 * beta[k] * beta[k];
+			sum.gradient[k] -= beta[k];
+			sum.hessian[k * 4 + k] += 1;
+		}
+		return sum;
+	};
+
+	double beta[4] = {};
+	Totals current = totals(beta);
+	for (int iteration = 0; iteration < 30; iteration++) {
+		vector<double> step = solve(vector<double>(current.hessian, current.hessian + 16),
+			vector<double>(current.gradient, current.gradient + 4));
+		// Halves the step until it improves the fit, and stops once the fit hardly improves.
+		double next[4];
+		Totals t;
+		double size = 1;
+		for (; size > 1e-4; size /= 2) {
+			for (int k = 0; k < 4; k++) {
+				next[k] = beta[k] + size * step[k];
+			}
+			t = totals(next);
+			if (t.logLikelihood > current.logLikelihood) {
+				break;
+			}
+		}
+		if (size <= 1e-4) {
+			break;
+		}
+		double gain = t.logLikelihood - current.logLikelihood;
+		copy(next, next + 4, beta);
+		current = t;
+		if (gain < 1e-6 * fabs(current.logLikelihood)) {
+			break;
+		}
+	}
+	for (int k = 0; k < 4; k++) {
+		w[k] = beta[k] / scale[k];
+	}
+	return true;
+}
+
+// The pattern codes of a sample, from the player to move's point of view, and its phase.
+struct Pattern_sample {
+	uint16_t codes[Pattern_layout::maxPatterns];
+	int phase;
+};
+
+// Fits the pattern weights by gradient descent on the squared error of the predicted margin, in tenths of a piece.
+// Each weight's step is divided by how many training positions use it, so rare codes move as fast as common ones
+// without overshooting. Stops at the step that does best on the held back positions.
+Pattern_eval fit_patterns(const vector<Sample>& samples, const Positional_table& table, int iterations, int num_threads) {
+	const int size = Pattern_eval::numPhases * patternLayout.phaseSize;
+	const int num_patterns = patternLayout.numPatterns;
+
+	vector<Pattern_sample> codes(samples.size());
+	parallel_for(num_threads, samples.size(), [&](int, size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			Board b;
+			for (int sq = 0; sq < 64; sq++) {
+				Square s = (samples[i].p >> sq & 1) ? Square::human : (samples[i].o >> sq & 1) ? Square::computer : Square::empty;
+				b.set(sq / 8, sq % 8, s);
+			}
+			Pattern_codes c;
+			c.set(b);
+			for (int p = 0; p < num_patterns; p++) {
+				codes[i].codes[p] = c.code(p, Square::human);
+			}
+			codes[i].phase = Pattern_eval::phase(b.num_empty_squares());
+		}
+	});
+
+	// Starts from weights that give the same scores as the positional table.
+	Pattern_eval start = Pattern_eval::from_positional_table(table);
+	vector<double> weights(size);
+	for (int ph = 0; ph < Pattern_eval::numPhases; ph++) {
+		for (int s = 0; s < numShapes; s++) {
+			int end = (s + 1 < numShapes) ? patternLayout.offset[s + 1] : patternLayout.phaseSize;
+			for (int code = 0; code < end - patternLayout.offset[s]; code++) {
+				weights[ph * patternLayout.phaseSize + patternLayout.offset[s] + code] = start.get_weight(ph, s, code);
+			}
+		}
+	}
+	auto predict = [&](size_t i) {
+		const double* w = weights.data() + codes[i].phase * patternLayout.phaseSize;
+		double sum = 0;
+		for (int p = 0; p < num_patterns; p++) {
+			sum += w[patternLayout.start[p] + codes[i].codes[p]];
+		}
+		return sum;
+	};
+
+	long long num_test = count_if(samples.begin(), samples.end(), [](const Sample& s) { return s.test; });
+	vector<double> uses(size);
+	for (size_t i = 0; i < samples.size(); i++) {
+		if (!samples[i].test) {
+			for (int p = 0; p < num_patterns; p++) {
+				uses[codes[i].phase * patternLayout.phaseSize + patternLayout.start[p] + codes[i].codes[p]]++;
+			}
+		}
+	}
+
+	// Keeps the weights that did best on the held back positions, as the later steps can start fitting the noise
+	// in the training games instead.
+	vector<double> best = weights;
+	double best_error = rms_error(samples, true, predict);
+	int best_iteration = 0;
+
+	vector<vector<double>> gradients(num_threads, vector<double>(size));
+	for (int iteration = 1; iteration <= iterations; iteration++) {
+		parallel_for(num_threads, samples.size(), [&](int t, size_t begin, size_t end) {
+			vector<double>& g = gradients[t];
+			fill(g.begin(), g.end(), 0);
+			for (size_t i = begin; i < end; i++) {
+				if (samples[i].test) {
+					continue;
+				}
+				double err = predict(i) - samples[i].margin * 10;
+				for (int p = 0; p < num_patterns; p++) {
+					g[codes[i].phase * patternLayout.phaseSize + patternLayout.start[p] + codes[i].codes[p]] += err;
+				}
+			}
+		});
+		// Each position's error is shared out between the patterns it has. The extra use
+		// in the divisor keeps codes seen only a few times from being fit to the noise in their games.
+		parallel_for(num_threads, size, [&](int, size_t begin, size_t end) {
+			for (size_t j = begin; j < end; j++) {
+				double g = 0;
+				for (int t = 0; t < num_threads; t++) {
+					g += gradients[t][j];
+				}
+				weights[j] -= g / (uses[j] + 4) / num_patterns;
+			}
+		});
+		double test_error = rms_error(samples, true, predict);
+		if (test_error < best_error || num_test == 0) {
+			best = weights;
+			best_error = test_error;
+			best_iteration = iteration;
+		}
+		if (iteration % 10 == 0 || iteration == iterations) {
+			cout << "  Pattern iteration " << iteration << ": error " << fixed << setprecision(2)
+				 << rms_error(samples, false, predict) << " pieces on training positions, "
+				 << test_error << " on held back positions" << endl;
+		}
+	}
+	weights = best;
+	cout << "Fit the patterns, keeping the weights from iteration " << best_iteration << " with an error of "
+		 << best_error << " pieces on held back positions." << endl;
+
+	Pattern_eval eval;
+	for (int ph = 0; ph < Pattern_eval::numPhases; ph++) {
+		for (int s = 0; s < numShapes; s++) {
+			int end = (s + 1 < numShapes) ? patternLayout.offset[s + 1] : patternLayout.phaseSize;
+			for (int code = 0; code < end - patternLayout.offset[s]; code++) {
+				eval.set_weight(ph, s, code, weights[ph * patternLayout.phaseSize + patternLayout.offset[s] + code]);
+			}
+		}
+	}
+	return eval;
+}
+
+int main(int argc, char* argv[]) {
+	string weights_file;
+	string patterns_file;
+	int num_threads = max(int(thread::hardware_concurrency()), 1);
+	int iterations = 50;
+	vector<string> inputs;
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if (arg == "--weights" && i + 1 < argc) {
+			weights_file = argv[++i];
+		} else if (arg == "--patterns" && i + 1 < argc) {
+			patterns_file = argv[++i];
+		} else if (arg == "--threads" && i + 1 < argc) {
+			num_threads = atoi(argv[++i]);
+		} else if (arg == "--iterations" && i + 1 < argc) {
+			iterations = atoi(argv[++i]);
+		} else {
+			inputs.push_back(arg);
+		}
+	}
+	if (inputs.empty() || (weights_file.empty() && patterns_file.empty()) || num_threads < 1 || iterations < 0) {
+		cout << "Usage: ./tune [--weights file] [--patterns file] [--threads n] [--iterations n] inputs..." << endl;
+		return 1;
+	}
+
+	vector<Sample> samples;
+	for (const string& input : inputs) {
+		ifstream in(input, ios::binary);
+		if (!in) {
+			cmpt::error("can't open " + input);
+		}
+		char magic[4] = {};
+		in.read(magic, 4);
+		if (equal(recordMagic, recordMagic + 4, magic)) {
+			read_records(input, samples);
+		} else {
+			read_positions(input, samples);
+		}
+	}
+	long long num_test = count_if(samples.begin(), samples.end(), [](const Sample& s) { return s.test; });
+	cout << "Read " << samples.size() << " positions, holding back " << num_test << " to test with." << endl;
+	if (samples.size() == num_test) {
+		cout << "There are too few positions to learn from." << endl;
+		return 1;
+	}
+
+	Heuristic_weights weights;
+	weights.table = fit_table(samples, num_threads);
+	auto fitted_score = [&](size_t i) {
+		return table_score(samples[i], weights.table);
+	};
+	cout << fixed << setprecision(2) << "The fitted table's error: " << rms_error(samples, false, fitted_score)
+		 << " pieces on training positions, " << rms_error(samples, true, fitted_score) << " on held back positions" << endl;
+
+	if (!weights_file.empty()) {
+		// get_combined_move scores moves with the positional table too, so the combined weights are fit to go with the
+		// fitted table, and the pair is only written if it picks the searching players' moves more often than the standard pair.
+		const Heuristic_weights standard;
+		double fitted_agree = 0;
+		double standard_agree = 0;
+		bool fitted_both = true;
+		for (bool late : {false, true}) {
+			double* w = late ? weights.combined.late : weights.combined.early;
+			Move_choices c = move_choices(samples, weights.table, weights.combined.lateEmpties, late);
+			if (!fit_combined(c, samples, num_threads, w)) {
+				cout << "No " << (late ? "late" : "early") << " game moves by searching players to learn from." << endl;
+				fitted_both = false;
+				continue;
+			}
+			// The fit makes the moves played likely rather than making them the highest scoring, which is what matters,
+			// so the pairs are compared on how often they score the move played highest.
+			const double* standard_w = late ? standard.combined.late : standard.combined.early;
+			Move_choices standard_c = move_choices(samples, standard.table, standard.combined.lateEmpties, late);
+			long long test_moves = count_if(c.sample.begin(), c.sample.end(), [&](int i) { return samples[i].test; });
+			double fitted_agreement = agreement(c, samples, true, w);
+			double standard_agreement = agreement(standard_c, samples, true, standard_w);
+			fitted_agree += fitted_agreement * test_moves;
+			standard_agree += standard_agreement * test_moves;
+			cout << "Fit the " << (late ? "late" : "early") << " game weights to " << c.start.size() - 1 << " moves: "
+				 << setprecision(4) << w[0] << " " << w[1] << " " << w[2] << " " << w[3] << setprecision(1)
+				 << ". On held back positions they pick the searching players' move " << 100 * fitted_agreement
+				 << "% of the time with the fitted table, the standard weights " << 100 * standard_agreement
+				 << "% with the standard table." << endl;
+		}
+		if (fitted_both && fitted_agree > standard_agree) {
+			weights.save(weights_file);
+			cout << "Wrote the fitted table and weights to " << weights_file << endl;
+		} else {
+			standard.save(weights_file);
+			cout << "The fitted table and weights don't do better than the standard ones, so wrote the standard table and weights to "
+				 << weights_file << endl;
+		}
+	}
+
+	if (!patterns_file.empty()) {
+		Pattern_eval eval = fit_patterns(samples, weights.table, iterations, num_threads);
+		eval.save(patterns_file);
+		cout << "Wrote " << patterns_file << endl;
+	}
+	return 0;
+}